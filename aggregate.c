@@ -0,0 +1,89 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <math.h>
+#include "aggregate.h"
+#include "log.h"
+
+void aggregatorAdd(Aggregator *aggregator, int objectId, int instance, double value) {
+    int index;
+    Aggregate *aggregate = NULL;
+
+    for (index = 0; index < aggregator->channelCount; index++) {
+        if (aggregator->channels[index].objectId == objectId && aggregator->channels[index].instance == instance) {
+            aggregate = &aggregator->channels[index];
+            break;
+        }
+    }
+
+    if (aggregate == NULL) {
+        if (aggregator->channelCount >= AGGREGATOR_MAX_CHANNELS) {
+            LOG(LOG_ERROR, "Too many aggregated values, /%d/%d ignored", objectId, instance);
+            return;
+        }
+        aggregate = &aggregator->channels[aggregator->channelCount++];
+        aggregate->objectId = objectId;
+        aggregate->instance = instance;
+        aggregate->count = 0;
+    }
+    aggregateAdd(aggregate, value);
+}
+
+void aggregateAdd(Aggregate *aggregate, double value) {
+    if (aggregate->count == 0) {
+        aggregate->mean = 0;
+        aggregate->m2 = 0;
+        aggregate->min = value;
+        aggregate->max = value;
+    }
+
+    aggregate->count++;
+    double delta = value - aggregate->mean;
+    aggregate->mean += delta / aggregate->count;
+    aggregate->m2 += delta * (value - aggregate->mean);
+    if (value < aggregate->min) {
+        aggregate->min = value;
+    }
+    if (value > aggregate->max) {
+        aggregate->max = value;
+    }
+}
+
+bool aggregateToSample(const Aggregate *aggregate, Sample *sample) {
+    if (aggregate->count == 0) {
+        return false;
+    }
+
+    sample->objectId = aggregate->objectId;
+    sample->instance = aggregate->instance;
+    sample->value = aggregate->mean;
+    sample->min = aggregate->min;
+    sample->max = aggregate->max;
+    sample->count = aggregate->count;
+    sample->stddev = aggregate->count > 1 ? sqrt(aggregate->m2 / (aggregate->count - 1)) : 0;
+    return true;
+}
+
+void aggregatorReset(Aggregator *aggregator) {
+    int index;
+    for (index = 0; index < aggregator->channelCount; index++) {
+        aggregator->channels[index].count = 0;
+    }
+}
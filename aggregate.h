@@ -0,0 +1,61 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file aggregate.h
+ * @brief Streaming per-window aggregation (mean, min, max, stddev, count) of high rate samples.
+ */
+
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include "sampleQueue.h"
+
+/** Maximum number of sensor values aggregated by one aggregator, a weather click produces three. */
+#define AGGREGATOR_MAX_CHANNELS (4)
+
+typedef struct {
+    int objectId;
+    int instance;
+    unsigned int count;
+    double mean;
+    double m2;          /**< sum of squared differences from the mean, Welford's method */
+    double min;
+    double max;
+} Aggregate;
+
+typedef struct {
+    Aggregate channels[AGGREGATOR_MAX_CHANNELS];
+    int channelCount;
+} Aggregator;
+
+/** Account value of /objectId/instance into the current window. */
+void aggregatorAdd(Aggregator *aggregator, int objectId, int instance, double value);
+
+/** Account value into a single aggregate, its identity is set by the caller. */
+void aggregateAdd(Aggregate *aggregate, double value);
+
+/** Fill sample with aggregate of a channel, returns false when the window got no values. */
+bool aggregateToSample(const Aggregate *aggregate, Sample *sample);
+
+/** Start new window for all channels. */
+void aggregatorReset(Aggregator *aggregator);
+
+#endif  /* AGGREGATE_H */
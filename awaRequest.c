@@ -0,0 +1,205 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <awa/common.h>
+#include <awa/server.h>
+#include "awaRequest.h"
+#include "scheduler.h"
+#include "stats.h"
+#include "log.h"
+
+typedef struct {
+    AwaRequest request;
+    int64_t submittedUs;
+} WindowEntry;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t submitted = PTHREAD_COND_INITIALIZER;
+static WindowEntry entries[AWA_REQUEST_WINDOW_MAX];
+static int head = 0;        // next entry to perform
+static int waiting = 0;     // entries submitted, not taken by a worker yet
+static int window = AWA_REQUEST_WINDOW_MAX;
+static AwaRequestStats stats;
+
+void awaRttInit(AwaRtt *rtt, int initialMs, int minMs, int maxMs) {
+    rtt->srttUs = 0;
+    rtt->rttvarUs = 0;
+    rtt->minMs = minMs < maxMs ? minMs : maxMs;
+    rtt->maxMs = maxMs;
+    rtt->timeoutMs = initialMs < rtt->minMs ? rtt->minMs : initialMs > maxMs ? maxMs : initialMs;
+}
+
+int awaRttTimeoutMs(const AwaRtt *rtt) {
+    return rtt->timeoutMs;
+}
+
+void awaRttUpdate(AwaRtt *rtt, int64_t startUs, AwaError result) {
+    int64_t sampleUs = statsStart() - startUs;
+    int64_t timeoutMs;
+
+    if (result == AwaError_Timeout) {
+        // nothing learned about the round trip, back off until the peer answers again
+        timeoutMs = (int64_t)rtt->timeoutMs * 2;
+    } else if (result == AwaError_Success || result == AwaError_Response) {
+        if (rtt->srttUs == 0) {
+            rtt->srttUs = sampleUs;
+            rtt->rttvarUs = sampleUs / 2;
+        } else {
+            int64_t delta = rtt->srttUs > sampleUs ? rtt->srttUs - sampleUs : sampleUs - rtt->srttUs;
+            rtt->rttvarUs += (delta - rtt->rttvarUs) / 4;
+            rtt->srttUs += (sampleUs - rtt->srttUs) / 8;
+        }
+        timeoutMs = (rtt->srttUs + 4 * rtt->rttvarUs) / 1000;
+    } else {
+        return;
+    }
+
+    if (timeoutMs < rtt->minMs) {
+        timeoutMs = rtt->minMs;
+    } else if (timeoutMs > rtt->maxMs) {
+        timeoutMs = rtt->maxMs;
+    }
+    rtt->timeoutMs = (int)timeoutMs;
+}
+
+void awaRequestSetWindow(int size) {
+    window = size < 1 ? 1 : size > AWA_REQUEST_WINDOW_MAX ? AWA_REQUEST_WINDOW_MAX : size;
+}
+
+bool awaRequestSubmit(const AwaRequest *request) {
+    pthread_mutex_lock(&lock);
+    if (stats.outstanding >= window) {
+        stats.rejected++;
+        pthread_mutex_unlock(&lock);
+        return false;
+    }
+
+    WindowEntry *entry = &entries[(head + waiting) % AWA_REQUEST_WINDOW_MAX];
+    entry->request = *request;
+    entry->submittedUs = statsStart();
+    waiting++;
+    stats.outstanding++;
+    stats.submitted++;
+    pthread_cond_signal(&submitted);
+    pthread_mutex_unlock(&lock);
+    return true;
+}
+
+/** Take the oldest waiting request, false when none came within AWA_REQUEST_WAIT_MS. */
+static bool takeRequest(WindowEntry *entry) {
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += AWA_REQUEST_WAIT_MS / 1000;
+    deadline.tv_nsec += (long)(AWA_REQUEST_WAIT_MS % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&lock);
+    while (waiting == 0) {
+        if (pthread_cond_timedwait(&submitted, &lock, &deadline) == ETIMEDOUT) {
+            pthread_mutex_unlock(&lock);
+            return false;
+        }
+    }
+    *entry = entries[head];
+    head = (head + 1) % AWA_REQUEST_WINDOW_MAX;
+    waiting--;
+    pthread_mutex_unlock(&lock);
+    return true;
+}
+
+static void finishRequest(const AwaRequest *request, AwaError result) {
+    if (request->complete != NULL) {
+        request->complete(request->context, result);
+    }
+
+    pthread_mutex_lock(&lock);
+    stats.outstanding--;
+    stats.completed++;
+    if (result == AwaError_Timeout) {
+        stats.timedOut++;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+static bool connectWorker(AwaRequestWorker *worker) {
+    if (worker->session == NULL && (worker->session = AwaServerSession_New()) == NULL) {
+        LOG(LOG_ERROR, "AwaServerSession_New() failed");
+        return false;
+    }
+    if (!worker->connected) {
+        worker->connected = AwaServerSession_Connect(worker->session) == AwaError_Success;
+        if (!worker->connected) {
+            LOG(LOG_WARN, "Worker can't connect to Awa server daemon");
+        }
+    }
+    return worker->connected;
+}
+
+void awaRequestWork(Producer *producer, void *context) {
+    AwaRequestWorker *worker = (AwaRequestWorker *)context;
+    WindowEntry entry;
+
+    // requests stay in the window while the worker has no session, which holds back the submitters too
+    if (!connectWorker(worker)) {
+        schedulerSleepMs(AWA_REQUEST_WAIT_MS);
+        return;
+    }
+    if (!takeRequest(&entry)) {
+        return;
+    }
+
+    statsRecord(StatsStage_RequestWait, entry.submittedUs, StatsOutcome_Ok);
+    const AwaRequest *request = &entry.request;
+    int64_t start = statsStart();
+    AwaError result = request->perform(producer, worker->session, request->context,
+                                       request->rtt != NULL ? awaRttTimeoutMs(request->rtt) : AWA_RTT_MIN_MS);
+    if (request->rtt != NULL) {
+        awaRttUpdate(request->rtt, start, result);
+    }
+    if (result == AwaError_IPCError || result == AwaError_SessionNotConnected || result == AwaError_SessionInvalid) {
+        AwaServerSession_Disconnect(worker->session);
+        worker->connected = false;
+    }
+    finishRequest(request, result);
+}
+
+void awaRequestWorkerClose(AwaRequestWorker *worker) {
+    if (worker->session == NULL) {
+        return;
+    }
+    if (worker->connected) {
+        AwaServerSession_Disconnect(worker->session);
+        worker->connected = false;
+    }
+    AwaServerSession_Free(&worker->session);
+}
+
+void awaRequestGetStats(AwaRequestStats *out) {
+    pthread_mutex_lock(&lock);
+    *out = stats;
+    pthread_mutex_unlock(&lock);
+}
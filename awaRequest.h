@@ -0,0 +1,107 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file awaRequest.h
+ * @brief Awa server requests kept in flight by a pool of workers, with timeouts adapted to observed round trips.
+ *
+ * Requests are submitted into a window of fixed size and performed by workers, each on its own server session, so
+ * a node which doesn't reply holds up only one of them. A request is completed through its callback on the worker
+ * which performed it. Submit fails once the window is full, the caller then skips the request and tries again later
+ * instead of letting requests queue up behind a slow daemon.
+ */
+
+#ifndef AWA_REQUEST_H
+#define AWA_REQUEST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <awa/server.h>
+#include "pipeline.h"
+
+//! \{
+#define AWA_REQUEST_WINDOW_MAX      (16)
+/** Round trips of a daemon on the same host, timeouts never go below it. */
+#define AWA_RTT_MIN_MS              (200)
+/** How long an idle worker waits for a request before giving its producer thread a chance to stop. */
+#define AWA_REQUEST_WAIT_MS         (1000)
+//! \}
+
+/**
+ * Round trip estimator of one peer, smoothed round trip and its variation as in RFC 6298. The timeout starts at its
+ * initial value, follows smoothed round trip + 4 * variation within [minMs, maxMs] and doubles after every timeout.
+ */
+typedef struct {
+    int64_t srttUs;         /**< zero before the first sample */
+    int64_t rttvarUs;
+    int timeoutMs;
+    int minMs;
+    int maxMs;
+} AwaRtt;
+
+void awaRttInit(AwaRtt *rtt, int initialMs, int minMs, int maxMs);
+
+int awaRttTimeoutMs(const AwaRtt *rtt);
+
+/** Account operation started at startUs (see statsStart()), only answered operations are sampled. */
+void awaRttUpdate(AwaRtt *rtt, int64_t startUs, AwaError result);
+
+/** Performs the request on the worker's session waiting up to timeoutMs, submits what it got through the producer. */
+typedef AwaError (*AwaRequestPerform)(Producer *producer, AwaServerSession *session, void *context, int timeoutMs);
+
+/** Called on the worker once the request is done, whatever the result. */
+typedef void (*AwaRequestComplete)(void *context, AwaError result);
+
+typedef struct {
+    AwaRequestPerform perform;
+    AwaRequestComplete complete;    /**< optional */
+    void *context;
+    AwaRtt *rtt;                    /**< estimator of the peer, owned by the request while it is in the window */
+} AwaRequest;
+
+/** State of a worker, zero initialized before it starts. */
+typedef struct {
+    AwaServerSession *session;
+    bool connected;
+} AwaRequestWorker;
+
+typedef struct {
+    unsigned long submitted;
+    unsigned long completed;
+    unsigned long timedOut;
+    unsigned long rejected;     /**< submits refused with the window full */
+    int outstanding;            /**< requests in the window now, waiting or performed */
+} AwaRequestStats;
+
+/** Set the window size, 1 to AWA_REQUEST_WINDOW_MAX. Called before workers start. */
+void awaRequestSetWindow(int window);
+
+/** Put request into the window, false when it is full. */
+bool awaRequestSubmit(const AwaRequest *request);
+
+/** Producer function of a worker, context is its AwaRequestWorker. Performs one request when there is any. */
+void awaRequestWork(Producer *producer, void *context);
+
+/** Disconnect and free the session of a worker, once its producer has stopped. */
+void awaRequestWorkerClose(AwaRequestWorker *worker);
+
+void awaRequestGetStats(AwaRequestStats *stats);
+
+#endif  /* AWA_REQUEST_H */
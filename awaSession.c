@@ -0,0 +1,193 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <awa/common.h>
+#include <awa/client.h>
+#include "awaSession.h"
+#include "ipsoCommon.h"
+#include "stats.h"
+#include "log.h"
+
+static AwaClientSession *session = NULL;
+static bool broken = false;
+static int backoffMs = 0;
+static struct timespec nextAttempt;
+static AwaSessionStats stats;
+static AwaSessionPrepare prepareSession = NULL;
+static int timeouts = 0;
+// the daemon may stall for a while in flash I/O, timeouts don't adapt below the fixed one it used to get
+static AwaRtt rtt = {0, 0, OPERATION_PERFORM_TIMEOUT, OPERATION_PERFORM_TIMEOUT, EXTENDED_OPERATION_PERFORM_TIMEOUT};
+
+static bool isDue(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec > nextAttempt.tv_sec ||
+        (now.tv_sec == nextAttempt.tv_sec && now.tv_nsec >= nextAttempt.tv_nsec);
+}
+
+/** Double backoff up to its limit and schedule next attempt somewhere in the upper half of it. */
+static void scheduleNextAttempt(void) {
+    static bool seeded = false;
+    if (!seeded) {
+        srand(time(NULL) ^ getpid());
+        seeded = true;
+    }
+
+    backoffMs = backoffMs == 0 ? RECONNECT_BACKOFF_MIN_MS : backoffMs * 2;
+    if (backoffMs > RECONNECT_BACKOFF_MAX_MS) {
+        backoffMs = RECONNECT_BACKOFF_MAX_MS;
+    }
+    int delayMs = backoffMs / 2 + rand() % (backoffMs / 2 + 1);
+
+    clock_gettime(CLOCK_MONOTONIC, &nextAttempt);
+    nextAttempt.tv_sec += delayMs / 1000;
+    nextAttempt.tv_nsec += (long)(delayMs % 1000) * 1000000;
+    if (nextAttempt.tv_nsec >= 1000000000) {
+        nextAttempt.tv_sec++;
+        nextAttempt.tv_nsec -= 1000000000;
+    }
+    LOG(LOG_WARN, "Next Awa connect attempt in %d ms", delayMs);
+}
+
+static void freeSession(void) {
+    if (session == NULL) {
+        return;
+    }
+    AwaClientSession_Disconnect(session);
+    AwaClientSession_Free(&session);
+    session = NULL;
+}
+
+/** Errors which mean the daemon is not reachable over the session, a timeout may be just a busy daemon. */
+static bool transportFailed(AwaError result) {
+    switch (result) {
+        case AwaError_IPCError:
+        case AwaError_SessionInvalid:
+        case AwaError_SessionNotConnected:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool connectToAwa(void) {
+    session = AwaClientSession_New();
+
+    if (session != NULL) {
+        if (AwaClientSession_SetIPCAsUDP(session, AWA_CLIENT_IPC_ADDRESS, AWA_CLIENT_IPC_PORT) == AwaError_Success) {
+            int64_t start = statsStart();
+            AwaError result = AwaClientSession_Connect(session);
+            statsRecord(StatsStage_Connect, start, statsAwaOutcome(result));
+            if (result == AwaError_Success) {
+                LOG(LOG_INFO, "Client Session Established: %s:%d\n", AWA_CLIENT_IPC_ADDRESS, AWA_CLIENT_IPC_PORT);
+                if (prepareSession != NULL) {
+                    AwaError prepared = prepareSession(session);
+                    if (transportFailed(prepared) || prepared == AwaError_Timeout) {
+                        LOG(LOG_ERROR, "Preparing client daemon failed\n");
+                        freeSession();
+                    }
+                }
+            } else {
+                LOG(LOG_ERROR, "AwaClientSession_Connect() failed\n");
+                AwaClientSession_Free(&session);
+                session = NULL;
+            }
+        } else {
+            LOG(LOG_ERROR, "AwaClientSession_SetIPCAsUDP() failed\n");
+            AwaClientSession_Free(&session);
+            session = NULL;
+        }
+    } else {
+        LOG(LOG_ERROR, "AwaClientSession_New() failed\n");
+    }
+    return session != NULL;
+}
+
+void awaSessionSetPrepare(AwaSessionPrepare prepare) {
+    prepareSession = prepare;
+}
+
+AwaClientSession *awaSessionAcquire(void) {
+    if (session != NULL && !broken) {
+        return session;
+    }
+    if (backoffMs > 0 && !isDue()) {
+        return NULL;
+    }
+
+    freeSession();
+    if (!connectToAwa()) {
+        stats.failedConnects++;
+        scheduleNextAttempt();
+        return NULL;
+    }
+
+    stats.connects++;
+    if (broken) {
+        stats.reconnects++;
+        LOG(LOG_INFO, "Awa session restored (reconnects: %lu, dropped cycles: %lu)",
+            stats.reconnects, stats.droppedCycles);
+    }
+    broken = false;
+    timeouts = 0;
+    backoffMs = 0;
+    return session;
+}
+
+bool awaSessionReportResult(AwaError result) {
+    if (result == AwaError_Timeout) {
+        // awaSessionMeasure() already doubled the timeout, the daemon gets the chance to catch up
+        if (++timeouts < AWA_SESSION_MAX_TIMEOUTS) {
+            LOG(LOG_WARN, "Awa operation timed out, next timeout %d ms", awaSessionTimeoutMs());
+            return false;
+        }
+    } else if (!transportFailed(result)) {
+        timeouts = 0;
+        return true;
+    }
+    if (!broken) {
+        LOG(LOG_WARN, "Awa session broken: %d", result);
+    }
+    broken = true;
+    return false;
+}
+
+int awaSessionTimeoutMs(void) {
+    return awaRttTimeoutMs(&rtt);
+}
+
+void awaSessionMeasure(int64_t startUs, AwaError result) {
+    awaRttUpdate(&rtt, startUs, result);
+}
+
+void awaSessionDropCycle(void) {
+    stats.droppedCycles++;
+}
+
+const AwaSessionStats *awaSessionGetStats(void) {
+    return &stats;
+}
+
+void awaSessionClose(void) {
+    freeSession();
+}
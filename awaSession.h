@@ -0,0 +1,84 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file awaSession.h
+ * @brief Long-lived Awa client session, reconnected with exponential backoff and jitter when it breaks.
+ */
+
+#ifndef AWA_SESSION_H
+#define AWA_SESSION_H
+
+#include <stdbool.h>
+#include <awa/client.h>
+#include "awaRequest.h"
+
+#define AWA_CLIENT_IPC_ADDRESS      "127.0.0.1"
+#define AWA_CLIENT_IPC_PORT         (12345)
+
+//! \{
+#define RECONNECT_BACKOFF_MIN_MS    (1000)
+#define RECONNECT_BACKOFF_MAX_MS    (300000)
+/** Timeouts in a row after which the session is taken for broken, single ones only back off the timeout. */
+#define AWA_SESSION_MAX_TIMEOUTS    (3)
+//! \}
+
+/**
+ * Set up the client daemon for a freshly connected session, which may have lost objects and instances in a restart.
+ * Transport errors returned make the connect fail.
+ */
+typedef AwaError (*AwaSessionPrepare)(AwaClientSession *session);
+
+typedef struct {
+    unsigned long connects;         /**< successful connects, including the first one */
+    unsigned long reconnects;       /**< connects after a broken session */
+    unsigned long failedConnects;
+    unsigned long droppedCycles;    /**< cycles not published because no session was available */
+} AwaSessionStats;
+
+/** Run prepare after every connect, before the session is handed out. */
+void awaSessionSetPrepare(AwaSessionPrepare prepare);
+
+/**
+ * Get connected session. Connects on first use and after the session was reported broken, but not before the
+ * backoff delay elapsed. Returns NULL when no session is available, caller should then drop the cycle.
+ */
+AwaClientSession *awaSessionAcquire(void);
+
+/**
+ * Inspect result of an operation performed on the session, false when it didn't get through. Transport errors mark the
+ * session broken, timeouts only once AWA_SESSION_MAX_TIMEOUTS of them came in a row.
+ */
+bool awaSessionReportResult(AwaError result);
+
+/** Timeout for the next operation on the session, adapted to round trips of the daemon. */
+int awaSessionTimeoutMs(void);
+
+/** Account round trip of an operation started at startUs (see statsStart()). */
+void awaSessionMeasure(int64_t startUs, AwaError result);
+
+/** Account a measurement cycle which couldn't be published. */
+void awaSessionDropCycle(void);
+
+const AwaSessionStats *awaSessionGetStats(void);
+
+void awaSessionClose(void);
+
+#endif  /* AWA_SESSION_H */
@@ -0,0 +1,133 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <stddef.h>
+#include <strings.h>
+#include <letmecreate/letmecreate.h>
+#include "bme280.h"
+#include "log.h"
+
+//! \{
+#define BME280_CTRL_HUM         (0xF2)
+#define BME280_STATUS           (0xF3)
+#define BME280_CTRL_MEAS        (0xF4)
+#define BME280_CONFIG           (0xF5)
+#define BME280_STATUS_MEASURING (0x08)
+#define BME280_MODE_SLEEP       (0x00)
+#define BME280_MODE_FORCED      (0x01)
+#define BME280_MODE_NORMAL      (0x03)
+//! \}
+
+// recommended modes of operation from the datasheet, chapter 3.5
+static const Bme280Profile profiles[] = {
+    { "lowpower", Bme280Mode_Forced, 1, 1, 1, 0, 0 },
+    { "humidity", Bme280Mode_Forced, 1, 0, 1, 0, 0 },
+    { "fast", Bme280Mode_Normal, 1, 2, 1, 4, 0.5 },
+    { "precise", Bme280Mode_Normal, 2, 16, 1, 16, 0.5 },
+};
+
+static const float standbyTimes[] = { 0.5, 62.5, 125, 250, 500, 1000, 10, 20 };
+
+const Bme280Profile *bme280ProfileFind(const char *name) {
+    size_t index;
+
+    for (index = 0; index < sizeof(profiles) / sizeof(profiles[0]); index++) {
+        if (strcasecmp(profiles[index].name, name) == 0) {
+            return &profiles[index];
+        }
+    }
+    LOG(LOG_ERROR, "Unknown Weather click profile %s", name);
+    return NULL;
+}
+
+const Bme280Profile *bme280ProfileForPeriod(long periodMs) {
+    return bme280ProfileFind(periodMs >= BME280_LOW_POWER_PERIOD ? "lowpower" : "fast");
+}
+
+/** Register encoding of oversampling and filter coefficient, both go in powers of two. */
+static uint8_t encodePower(uint8_t value, uint8_t lowest) {
+    uint8_t code = 0;
+
+    if (value == 0) {
+        return 0;
+    }
+    while (value > lowest) {
+        value >>= 1;
+        code++;
+    }
+    return code + 1;
+}
+
+static uint8_t encodeStandby(float standbyMs) {
+    uint8_t code;
+
+    for (code = 0; code < sizeof(standbyTimes) / sizeof(standbyTimes[0]); code++) {
+        if (standbyTimes[code] == standbyMs) {
+            return code;
+        }
+    }
+    return 0;
+}
+
+double bme280ConversionMs(const Bme280Profile *profile, bool maximum) {
+    double step = maximum ? 2.3 : 2.0;
+    double time = (maximum ? 1.25 : 1.0) + step * profile->temperatureOversampling;
+
+    if (profile->pressureOversampling > 0) {
+        time += step * profile->pressureOversampling + step / 4;
+    }
+    if (profile->humidityOversampling > 0) {
+        time += step * profile->humidityOversampling + step / 4;
+    }
+    return time;
+}
+
+static uint8_t controlMeasurement(const Bme280Profile *profile, uint8_t mode) {
+    return encodePower(profile->temperatureOversampling, 1) << 5 | encodePower(profile->pressureOversampling, 1) << 2 |
+           mode;
+}
+
+bool bme280Configure(const Bme280Profile *profile) {
+    // config is ignored in normal mode and ctrl_hum applies only after ctrl_meas is written, hence the order
+    if (i2c_write_register(BME280_ADDRESS, BME280_CTRL_MEAS, controlMeasurement(profile, BME280_MODE_SLEEP)) < 0 ||
+        i2c_write_register(BME280_ADDRESS, BME280_CONFIG,
+                           encodeStandby(profile->standbyMs) << 5 | encodePower(profile->filter, 2) << 2) < 0 ||
+        i2c_write_register(BME280_ADDRESS, BME280_CTRL_HUM, encodePower(profile->humidityOversampling, 1)) < 0 ||
+        i2c_write_register(BME280_ADDRESS, BME280_CTRL_MEAS, controlMeasurement(profile, BME280_MODE_SLEEP)) < 0) {
+        LOG(LOG_ERROR, "Configuring BME280 failed");
+        return false;
+    }
+    return true;
+}
+
+bool bme280Start(const Bme280Profile *profile, Bme280Mode mode) {
+    uint8_t control = controlMeasurement(profile, mode == Bme280Mode_Forced ? BME280_MODE_FORCED : BME280_MODE_NORMAL);
+    return i2c_write_register(BME280_ADDRESS, BME280_CTRL_MEAS, control) >= 0;
+}
+
+bool bme280Measuring(bool *measuring) {
+    uint8_t status = 0;
+
+    if (i2c_read_register(BME280_ADDRESS, BME280_STATUS, &status) < 0) {
+        return false;
+    }
+    *measuring = (status & BME280_STATUS_MEASURING) != 0;
+    return true;
+}
@@ -0,0 +1,74 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file bme280.h
+ * @brief Acquisition profiles of the BME280 on the Weather click: mode, oversampling and IIR filter.
+ *
+ * LetMeCreate enables the sensor and compensates its readings, these functions only change how it converts. They
+ * talk to the currently selected I2C bus, callers serialize them with other transfers.
+ */
+
+#ifndef BME280_H
+#define BME280_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! \{
+#define BME280_ADDRESS          (0x76)
+/** Shortest sampling period which still gets the low power profile when none is chosen. */
+#define BME280_LOW_POWER_PERIOD (1000)
+//! \}
+
+typedef enum {
+    Bme280Mode_Forced,      /**< one conversion per read, sleeps in between */
+    Bme280Mode_Normal       /**< converts continuously, reads take the latest result */
+} Bme280Mode;
+
+typedef struct {
+    const char *name;           /**< value of --profile1/--profile2 */
+    Bme280Mode mode;
+    uint8_t temperatureOversampling;    /**< 1, 2, 4, 8 or 16, 0 skips the channel */
+    uint8_t pressureOversampling;
+    uint8_t humidityOversampling;
+    uint8_t filter;             /**< IIR filter coefficient: 0 (off), 2, 4, 8 or 16 */
+    float standbyMs;            /**< normal mode pause between conversions: 0.5, 10, 20, 62.5, 125, 250, 500, 1000 */
+} Bme280Profile;
+
+/** Find profile by name, NULL for unknown names. */
+const Bme280Profile *bme280ProfileFind(const char *name);
+
+/** Profile used when none is chosen: low power for slow sampling, fast one below BME280_LOW_POWER_PERIOD. */
+const Bme280Profile *bme280ProfileForPeriod(long periodMs);
+
+/** Conversion time of the profile by the datasheet formula, typical or maximum. */
+double bme280ConversionMs(const Bme280Profile *profile, bool maximum);
+
+/** Write oversampling and filter of the profile, leaving the sensor in sleep mode. */
+bool bme280Configure(const Bme280Profile *profile);
+
+/** Start single conversion in forced mode, or continuous ones in normal mode. */
+bool bme280Start(const Bme280Profile *profile, Bme280Mode mode);
+
+/** Check whether a conversion is still running. */
+bool bme280Measuring(bool *measuring);
+
+#endif  /* BME280_H */
@@ -0,0 +1,106 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include "breaker.h"
+#include "scheduler.h"
+#include "log.h"
+
+bool breakerAllow(Breaker *breaker) {
+    int64_t now = schedulerNowMs();
+
+    if (atomic_load(&breaker->state) == BreakerState_Open) {
+        if (now < breaker->retryMs) {
+            return false;
+        }
+        atomic_store(&breaker->state, BreakerState_HalfOpen);
+    }
+    // zero marks an idle device, a clock starting at zero must not hide the first acquisition
+    atomic_store(&breaker->busySinceMs, now > 0 ? now : 1);
+    return true;
+}
+
+void breakerCancel(Breaker *breaker) {
+    atomic_store(&breaker->busySinceMs, 0);
+}
+
+void breakerSuccess(Breaker *breaker, const char *name) {
+    atomic_store(&breaker->busySinceMs, 0);
+    if (atomic_load(&breaker->state) != BreakerState_Closed) {
+        LOG(LOG_WARN, "%s recovered after %d failures", name, breaker->failures);
+        atomic_store(&breaker->state, BreakerState_Closed);
+    }
+    breaker->failures = 0;
+    breaker->backoffMs = 0;
+}
+
+void breakerFailure(Breaker *breaker, const char *name) {
+    atomic_store(&breaker->busySinceMs, 0);
+    breaker->failures++;
+    if (atomic_load(&breaker->state) == BreakerState_Closed && breaker->failures < BREAKER_THRESHOLD) {
+        return;
+    }
+
+    // a failed probe doubles the quarantine
+    breaker->backoffMs = breaker->backoffMs == 0 ? BREAKER_RETRY_MIN_MS : breaker->backoffMs * 2;
+    if (breaker->backoffMs > BREAKER_RETRY_MAX_MS) {
+        breaker->backoffMs = BREAKER_RETRY_MAX_MS;
+    }
+    breaker->retryMs = schedulerNowMs() + breaker->backoffMs;
+    if (atomic_load(&breaker->state) == BreakerState_Closed) {
+        atomic_fetch_add(&breaker->trips, 1);
+    }
+    atomic_store(&breaker->state, BreakerState_Open);
+    LOG(LOG_ERROR, "%s quarantined for %d ms after %d failures", name, breaker->backoffMs, breaker->failures);
+}
+
+bool breakerHung(const Breaker *breaker, long deadlineMs) {
+    int64_t busySinceMs = atomic_load(&breaker->busySinceMs);
+    return busySinceMs != 0 && schedulerNowMs() - busySinceMs > deadlineMs;
+}
+
+bool breakerTripHung(Breaker *breaker, long deadlineMs, const char *name) {
+    int closed = BreakerState_Closed;
+
+    if (!breakerHung(breaker, deadlineMs) ||
+        !atomic_compare_exchange_strong(&breaker->state, &closed, BreakerState_Open)) {
+        return false;
+    }
+    atomic_fetch_add(&breaker->trips, 1);
+    LOG(LOG_ERROR, "%s quarantined, hung past its deadline of %ld ms", name, deadlineMs);
+    return true;
+}
+
+bool breakerHealthy(const Breaker *breaker, long deadlineMs) {
+    return atomic_load(&breaker->state) == BreakerState_Closed && !breakerHung(breaker, deadlineMs);
+}
+
+const char *breakerDescribe(const Breaker *breaker, long deadlineMs) {
+    if (breakerHung(breaker, deadlineMs)) {
+        return "hung";
+    }
+    switch (atomic_load(&breaker->state)) {
+        case BreakerState_Open:
+            return "quarantined";
+        case BreakerState_HalfOpen:
+            return "probing";
+        default:
+            return "ok";
+    }
+}
@@ -0,0 +1,86 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file breaker.h
+ * @brief Circuit breaker isolating a failing sensor or remote node from the rest of the station.
+ *
+ * Every acquisition of the guarded device is bracketed by breakerAllow() and breakerSuccess()/breakerFailure().
+ * BREAKER_THRESHOLD consecutive failures open the breaker: the device is quarantined and not acquired until its retry
+ * time. A single probe then runs half open, it closes the breaker again or doubles the quarantine up to
+ * BREAKER_RETRY_MAX_MS. Acquisitions are expected from one thread at a time, the state may be read from any. An
+ * acquisition stuck past its deadline never reports back, breakerTripHung() lets another thread quarantine the device.
+ */
+
+#ifndef BREAKER_H
+#define BREAKER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+//! \{
+#define BREAKER_THRESHOLD       (3)
+#define BREAKER_RETRY_MIN_MS    (1000)
+#define BREAKER_RETRY_MAX_MS    (300000)
+//! \}
+
+typedef enum {
+    BreakerState_Closed = 0,    /**< healthy, acquired as scheduled */
+    BreakerState_Open,          /**< quarantined until retryMs */
+    BreakerState_HalfOpen       /**< probe after the quarantine running */
+} BreakerState;
+
+/** Zero initialized breaker is closed. */
+typedef struct {
+    atomic_int state;
+    atomic_llong busySinceMs;   /**< schedulerNowMs() the running acquisition started at, 0 when idle */
+    atomic_ulong trips;
+    int failures;               /**< consecutive failures */
+    int backoffMs;
+    int64_t retryMs;
+} Breaker;
+
+/** True when the device may be acquired now, the acquisition then counts as running. */
+bool breakerAllow(Breaker *breaker);
+
+/** Acquisition allowed but not started after all, it counts neither as success nor as failure. */
+void breakerCancel(Breaker *breaker);
+
+void breakerSuccess(Breaker *breaker, const char *name);
+
+void breakerFailure(Breaker *breaker, const char *name);
+
+/** True while the running acquisition is past its deadline, the device is likely hung. */
+bool breakerHung(const Breaker *breaker, long deadlineMs);
+
+/**
+ * Open the closed breaker of a device hung past deadlineMs, safe to call from any thread. The stuck acquisition sets the
+ * retry time with its breakerFailure() once it returns. True when the breaker was tripped.
+ */
+bool breakerTripHung(Breaker *breaker, long deadlineMs, const char *name);
+
+/** Healthy when closed and not hung. */
+bool breakerHealthy(const Breaker *breaker, long deadlineMs);
+
+/** Short description for reports: ok, hung, quarantined or probing. */
+const char *breakerDescribe(const Breaker *breaker, long deadlineMs);
+
+#endif  /* BREAKER_H */
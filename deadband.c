@@ -0,0 +1,127 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include "deadband.h"
+#include "log.h"
+
+typedef struct {
+    int objectId;
+    double absolute;
+    double relative;    // fraction of last published value
+} Threshold;
+
+typedef struct {
+    int objectId;
+    int instance;
+    double lastValue;
+    int64_t lastSentMs;
+    const Threshold *threshold;
+} Channel;
+
+static Threshold thresholds[DEADBAND_MAX_OBJECTS];
+static int thresholdCount = 0;
+static Channel channels[DEADBAND_MAX_CHANNELS];
+static int channelCount = 0;
+static long heartbeatMs = DEFAULT_HEARTBEAT_MS;
+static DeadbandStats stats;
+
+bool deadbandConfigure(const char *text) {
+    int objectId;
+    double absolute = 0, relative = 0;
+
+    if (sscanf(text, "%d=%lf,%lf", &objectId, &absolute, &relative) < 2 || absolute < 0 || relative < 0) {
+        LOG(LOG_ERROR, "Invalid deadband %s", text);
+        return false;
+    }
+    if (thresholdCount >= DEADBAND_MAX_OBJECTS) {
+        LOG(LOG_ERROR, "Too many deadbands, %s ignored", text);
+        return false;
+    }
+
+    thresholds[thresholdCount].objectId = objectId;
+    thresholds[thresholdCount].absolute = absolute;
+    thresholds[thresholdCount].relative = relative / 100;
+    thresholdCount++;
+    return true;
+}
+
+void deadbandSetHeartbeat(long ms) {
+    heartbeatMs = ms;
+}
+
+static const Threshold *findThreshold(int objectId) {
+    int index;
+    for (index = 0; index < thresholdCount; index++) {
+        if (thresholds[index].objectId == objectId) {
+            return &thresholds[index];
+        }
+    }
+    return NULL;
+}
+
+static Channel *findChannel(int objectId, int instance) {
+    int index;
+    for (index = 0; index < channelCount; index++) {
+        if (channels[index].objectId == objectId && channels[index].instance == instance) {
+            return &channels[index];
+        }
+    }
+    return NULL;
+}
+
+bool deadbandPass(int objectId, int instance, double value, int64_t nowMs, bool force) {
+    Channel *channel = findChannel(objectId, instance);
+
+    if (channel == NULL) {
+        const Threshold *threshold = findThreshold(objectId);
+        if (threshold == NULL || channelCount >= DEADBAND_MAX_CHANNELS) {
+            stats.sent++;
+            return true;
+        }
+
+        // first value of a channel always goes out
+        channel = &channels[channelCount++];
+        channel->objectId = objectId;
+        channel->instance = instance;
+        channel->threshold = threshold;
+    } else {
+        double change = fabs(value - channel->lastValue);
+        bool moved = (channel->threshold->absolute > 0 && change >= channel->threshold->absolute) ||
+                     (channel->threshold->relative > 0 &&
+                      change >= channel->threshold->relative * fabs(channel->lastValue));
+
+        if (!moved && !force && nowMs - channel->lastSentMs < heartbeatMs) {
+            stats.suppressed++;
+            LOG(LOG_DEBUG, "Value %f of /%d/%d within deadband", value, objectId, instance);
+            return false;
+        }
+    }
+
+    channel->lastValue = value;
+    channel->lastSentMs = nowMs;
+    stats.sent++;
+    return true;
+}
+
+const DeadbandStats *deadbandGetStats(void) {
+    return &stats;
+}
@@ -0,0 +1,62 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file deadband.h
+ * @brief Report-on-change filter: values are published only when they move past a per-object threshold or the
+ * heartbeat interval expires.
+ */
+
+#ifndef DEADBAND_H
+#define DEADBAND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! \{
+#define DEADBAND_MAX_OBJECTS    (8)
+#define DEADBAND_MAX_CHANNELS   (256)
+/** Default maximum silence of a sensor when deadband is configured, in ms. */
+#define DEFAULT_HEARTBEAT_MS    (15 * 60 * 1000)
+//! \}
+
+typedef struct {
+    unsigned long sent;
+    unsigned long suppressed;
+} DeadbandStats;
+
+/**
+ * Configure thresholds of object from "<object>=<absolute>[,<relative %>]" e.g. "3303=0.2" or "3325=5,2". Value has
+ * to change by at least one of thresholds given to get published.
+ */
+bool deadbandConfigure(const char *text);
+
+/** Set maximum time in ms a sensor value may stay unpublished. */
+void deadbandSetHeartbeat(long heartbeatMs);
+
+/**
+ * Decide whether value of /objectId/instance taken at nowMs (monotonic) gets published and account the decision.
+ * Objects without thresholds always pass, and so does a forced value.
+ */
+bool deadbandPass(int objectId, int instance, double value, int64_t nowMs, bool force);
+
+const DeadbandStats *deadbandGetStats(void);
+
+#endif  /* DEADBAND_H */
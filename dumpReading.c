@@ -24,8 +24,10 @@
 #include <signal.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <letmecreate/letmecreate.h>
 #include <getopt.h>
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -34,21 +36,84 @@
 #include <awa/types.h>
 #include <awa/server.h>
 #include "log.h"
-
-#define OPERATION_PERFORM_TIMEOUT 1000
-#define EXTENDED_OPERATION_PERFORM_TIMEOUT 5000
-#define CLIENT_ID "MK_NODE1"
-
-typedef float (*SensorReadFunc)(uint8_t);
-
-typedef enum {
-    ClickType_None = 0,
-    ClickType_Thermo3,
-    ClickType_Weather,
-    ClickType_Thunder,
-    ClickType_AirQuality,
-    ClickType_CODetector
-} ClickType;
+#include "ipsoCommon.h"
+#include "measurementBatch.h"
+#include "extremes.h"
+#include "awaSession.h"
+#include "awaRequest.h"
+#include "remoteRead.h"
+#include "remoteObserve.h"
+#include "remoteNodes.h"
+#include "pipeline.h"
+#include "spool.h"
+#include "aggregate.h"
+#include "scheduler.h"
+#include "deadband.h"
+#include "stats.h"
+#include "sensors.h"
+#include "thunder.h"
+#include "history.h"
+#include "liveValues.h"
+#include "trace.h"
+#include "ipsoObjects.h"
+#include "breaker.h"
+
+#define PUBLISH_WAIT_TIMEOUT 1000
+#define DISCOVERY_PROCESS_TIMEOUT 1000
+#define DEFAULT_NODE_TIMEOUT 2000
+#define DEFAULT_READ_DEADLINE 1000
+#define SERVER_CONNECT_DEADLINE 60000
+#define DEFAULT_WORKER_COUNT 2
+#define DEFAULT_REQUEST_WINDOW 4
+/** One producer is left for discovery. */
+#define MAX_WORKER_COUNT (PIPELINE_MAX_PRODUCERS - 1)
+#define MAX_REPLAY_BATCHES_PER_CYCLE 16
+#define EVENT_WAIT_TIMEOUT 1000
+/** Highest sampling rate in Hz, the sampling period is counted in whole ms. */
+#define MAX_SAMPLE_RATE 1000
+#define REPLAY_MAX_CHANNELS BATCH_MAX_CHANNELS
+#define CYCLE_SAMPLES_CAPACITY (PIPELINE_MAX_PRODUCERS * SAMPLE_QUEUE_SIZE)
+
+#define SLOT_COUNT 2
+
+enum {
+    Option_Pmin = 256,
+    Option_Pmax,
+    Option_Step,
+    Option_SpoolSize,
+    Option_Period1,
+    Option_Period2,
+    Option_Profile1,
+    Option_Profile2,
+    Option_Deadband,
+    Option_Heartbeat,
+    Option_Stats,
+    Option_StatsInterval,
+    Option_StatsObject,
+    Option_Nodes,
+    Option_Workers,
+    Option_NodeTimeout,
+    Option_Window,
+    Option_History,
+    Option_HistorySize,
+    Option_Live,
+    Option_Trace,
+    Option_Replay,
+    Option_ReplayRepeat,
+    Option_Deadline
+};
+
+//state of a producer measuring a slot
+typedef struct {
+    int index;
+    SensorSlot sensor;
+    Producer *producer;
+    Aggregator aggregator;
+    int64_t windowEnd;  //monotonic ms
+    Breaker breaker;
+    atomic_int busBusy; //reads in a row which didn't get the I2C bus
+    char name[16];      //for reports, e.g. "thermo3@slot1"
+} SlotContext;
 
 typedef enum {
     IfaceType_microBus = 0,
@@ -56,40 +121,44 @@ typedef enum {
     IfaceType_Unknown = 99
 } IfaceType;
 
-ClickType g_Click1Type = ClickType_None;
-ClickType g_Click2Type = ClickType_None;
+const SensorType *g_SlotTypes[SLOT_COUNT];
 IfaceType g_IfaceType = IfaceType_microBus;
 AwaServerSession *g_server_session;
+AwaRequestWorker g_Workers[MAX_WORKER_COUNT];
+int g_WorkerCount = DEFAULT_WORKER_COUNT;
+int g_RequestWindow = DEFAULT_REQUEST_WINDOW;
+long g_NodeTimeoutMs = DEFAULT_NODE_TIMEOUT;
+const char *g_NodesFile = DEFAULT_NODES_FILE;
+int64_t g_NextPollMs;
+SlotContext g_Slots[SLOT_COUNT] = {{.index = 0}, {.index = 1}};
+Producer *g_RemoteProducer;
 
-AwaClientSession* g_ClientSession;
 int g_LogLevel = LOG_INFO;
 FILE* g_DebugStream;
-int g_SleepTime = 60;   //default 1 minute
-
-ClickType configDecodeClickType(char* type) {
-    static struct element {
-        char* name;
-        ClickType mapsTo;
-    };
-    static struct element types[] = {
-            {"air", ClickType_AirQuality},
-            {"co", ClickType_CODetector},
-            {"thermo3", ClickType_Thermo3},
-            {"thunder", ClickType_Thunder},
-            {"weather", ClickType_Weather},
-            {NULL, -1}
-    };
-
-    struct element* iter = &types[0];
-    while (iter->name != NULL) {
-        if (strcasecmp(iter->name, type) == 0) {
-            return iter->mapsTo;
-        }
-        iter++;
-    }
-
-    return ClickType_None;
-}
+long g_PeriodMs = 60000;    //default 1 minute
+long g_SlotPeriodMs[2];     //zero uses g_PeriodMs
+const char *g_SlotProfiles[2];  //NULL lets the click pick one by its period
+float g_SampleRate = 0;     //Hz, zero takes single sample every period
+long g_ReadDeadlineMs = DEFAULT_READ_DEADLINE;  //capped by the period of reads
+const char *g_ExtremesFile = DEFAULT_EXTREMES_FILE;
+bool g_Observe = false;
+ObserveAttributes g_ObserveAttributes = {-1, -1, -1};
+const char *g_SpoolFile = DEFAULT_SPOOL_FILE;
+unsigned int g_SpoolSize = DEFAULT_SPOOL_CAPACITY;
+const char *g_HistoryFile = DEFAULT_HISTORY_FILE;
+unsigned int g_HistorySizeKb = DEFAULT_HISTORY_SIZE;
+const char *g_LiveTable = LIVE_VALUES_DEFAULT_NAME;
+const char *g_TraceFile = NULL;
+const char *g_ReplayFile = NULL;
+int g_ReplayRepeat = 1;
+Aggregate g_ReplayChannels[REPLAY_MAX_CHANNELS];
+int g_ReplayChannelCount;
+Sample g_CycleSamples[CYCLE_SAMPLES_CAPACITY];
+int g_CycleSampleCount;
+volatile sig_atomic_t g_Running = 1;
+const char *g_StatsFile = DEFAULT_STATS_FILE;
+long g_StatsIntervalMs = 60000;
+bool g_PublishStats = false;
 
 static IfaceType configDecodeIfaceType(char *type)
 {
@@ -111,12 +180,54 @@ static void printUsage(const char *program)
         "                  air, co, none, thermo3, thunder, weather\n"
         " -2, --click2   : Type of click installed in microBus slot 2 (default:none)\n"
         "                  air, co, none, thermo3, thunder, weather\n"
-        " -s, --sleep    : delay between measurements in seconds. (default: 60s)\n"
+        " -s, --sleep    : period of measurements in seconds, or in ms with 'ms' suffix (default: 60s)\n"
+        "     --period1  : period of click in slot 1, overrides --sleep\n"
+        "     --period2  : period of click in slot 2, overrides --sleep\n"
+        "     --profile1 : acquisition profile of Weather click in slot 1 (default: by period)\n"
+        "     --profile2 : acquisition profile of Weather click in slot 2 (default: by period)\n"
+        "                  lowpower, humidity, fast, precise\n"
+        " -r, --rate     : Sample clicks at this rate in Hz and publish mean of each period\n"
+        "                  (microBus only, default: single sample per period)\n"
+        "     --deadline : Longest time a click read may take, never longer than its period (default: 1s),\n"
+        "                  clicks failing 3 reads in a row are quarantined with exponential retry\n"
         " -v, --logLevel : Debug level from 1 to 5\n"
         "                   fatal(1), error(2), warning(3), info(4), debug(5) and max(>5)\n"
         "                   default is info.\n"
         " -i, --iface    : Interface on which sensor is available (default:microBus)\n"
         "                  microBus, AwaLWM2M\n"
+        " -n, --node     : Client id of remote node to relay, can be repeated (AwaLWM2M only,\n"
+        "                  default: all clients registered with the server)\n"
+        "     --nodes    : File keeping order of discovered nodes, which selects their instances\n"
+        "                  (default: " DEFAULT_NODES_FILE ")\n"
+        "     --workers  : Number of nodes read at once, 1 to 3 (default: 2)\n"
+        "     --nodeTimeout: Longest time to wait for reply of a node, shorter once its round trips\n"
+        "                  are known (default: 2s)\n"
+        "     --window   : Number of node reads waiting or in progress at once, 1 to 16 (default: 4)\n"
+        " -o, --observe  : Observe remote nodes instead of polling them (AwaLWM2M only)\n"
+        "     --pmin     : Minimum period between notifications in seconds\n"
+        "     --pmax     : Maximum period between notifications in seconds\n"
+        "     --step     : Minimum change of value which triggers a notification\n"
+        " -f, --spool    : File buffering samples while they can't be published\n"
+        "                  (default: " DEFAULT_SPOOL_FILE ")\n"
+        "     --spoolSize: Capacity of the spool in samples, 0 disables it (default: 32768)\n"
+        "     --history  : File keeping compressed history of all measured values, empty keeps it\n"
+        "                  in memory only (default: " DEFAULT_HISTORY_FILE ")\n"
+        "     --historySize: Memory for the history in KB, 0 disables it (default: 4096)\n"
+        "     --live     : Shared memory segment receiving latest value of every channel, empty\n"
+        "                  disables it (default: " LIVE_VALUES_DEFAULT_NAME ")\n"
+        "     --trace    : Record sensor reads, publishing cycles and stage timings into this file\n"
+        "     --replay   : Publish reads of a recorded trace as fast as possible and report throughput,\n"
+        "                  instead of reading clicks or nodes\n"
+        "     --replayRepeat: Number of times the trace is replayed (default: 1)\n"
+        "     --deadband : Publish value of object only when it changes by absolute or relative (%%)\n"
+        "                  threshold, e.g. 3303=0.2 or 3325=5,2. Can be repeated for more objects\n"
+        "     --heartbeat: Maximum time value within deadband stays unpublished (default: 15 min)\n"
+        " -x, --extremes : File keeping min/max measured values across restarts\n"
+        "                  (default: " DEFAULT_EXTREMES_FILE ")\n"
+        "     --stats    : File receiving latencies and counters of all stages, empty disables it\n"
+        "                  (default: " DEFAULT_STATS_FILE ", dumped to log on SIGUSR1 too)\n"
+        "     --statsInterval: Period of writing the stats file (default: 60s)\n"
+        "     --statsObject: Publish stats as instances of LWM2M object 26241 too\n"
         " -h, --help     : prints this help\n",
         program);
 }
@@ -133,30 +244,192 @@ bool loadConfiguration(int argc, char **argv) {
         { "logLevel", required_argument, 0, 'v'},
         { "help", no_argument, 0, 'h'},
         { "sleep", required_argument, 0, 's'},
+        { "rate", required_argument, 0, 'r'},
+        { "period1", required_argument, 0, Option_Period1},
+        { "period2", required_argument, 0, Option_Period2},
+        { "profile1", required_argument, 0, Option_Profile1},
+        { "profile2", required_argument, 0, Option_Profile2},
+        { "deadband", required_argument, 0, Option_Deadband},
+        { "heartbeat", required_argument, 0, Option_Heartbeat},
+        { "extremes", required_argument, 0, 'x'},
+        { "observe", no_argument, 0, 'o'},
+        { "pmin", required_argument, 0, Option_Pmin},
+        { "pmax", required_argument, 0, Option_Pmax},
+        { "step", required_argument, 0, Option_Step},
+        { "spool", required_argument, 0, 'f'},
+        { "spoolSize", required_argument, 0, Option_SpoolSize},
+        { "history", required_argument, 0, Option_History},
+        { "historySize", required_argument, 0, Option_HistorySize},
+        { "live", required_argument, 0, Option_Live},
+        { "trace", required_argument, 0, Option_Trace},
+        { "replay", required_argument, 0, Option_Replay},
+        { "replayRepeat", required_argument, 0, Option_ReplayRepeat},
+        { "deadline", required_argument, 0, Option_Deadline},
+        { "stats", required_argument, 0, Option_Stats},
+        { "statsInterval", required_argument, 0, Option_StatsInterval},
+        { "statsObject", no_argument, 0, Option_StatsObject},
+        { "node", required_argument, 0, 'n'},
+        { "nodes", required_argument, 0, Option_Nodes},
+        { "workers", required_argument, 0, Option_Workers},
+        { "nodeTimeout", required_argument, 0, Option_NodeTimeout},
+        { "window", required_argument, 0, Option_Window},
         { 0, 0, 0, 0 } };
 
         int option_index = 0;
-        c = getopt_long(argc, argv, "s:1:2:c:i:hv:", long_options, &option_index);
+        c = getopt_long(argc, argv, "s:1:2:c:i:hv:x:of:r:n:", long_options, &option_index);
 
         if (c == -1) break;
 
         switch (c) {
             case '1':
-                g_Click1Type = configDecodeClickType(optarg);
+                g_SlotTypes[0] = sensorTypeFind(optarg);
                 break;
 
             case '2':
-                g_Click2Type = configDecodeClickType(optarg);
+                g_SlotTypes[1] = sensorTypeFind(optarg);
                 break;
 
             case 's':
-                g_SleepTime = atoi(optarg);
+                g_PeriodMs = parsePeriodMs(optarg);
+                success = success && g_PeriodMs > 0;
                 break;
 
+            case Option_Period1:
+            case Option_Period2:
+                g_SlotPeriodMs[c == Option_Period1 ? 0 : 1] = parsePeriodMs(optarg);
+                success = success && g_SlotPeriodMs[c == Option_Period1 ? 0 : 1] > 0;
+                break;
+
+            case Option_Profile1:
+            case Option_Profile2:
+                g_SlotProfiles[c == Option_Profile1 ? 0 : 1] = optarg;
+                break;
+
+            case 'r': {
+                char *end = NULL;
+                g_SampleRate = strtof(optarg, &end);
+                if (end == optarg || *end != '\0' || !(g_SampleRate > 0 && g_SampleRate <= MAX_SAMPLE_RATE)) {
+                    LOG(LOG_ERROR, "Sampling rate must be above 0 and up to %d Hz\n", MAX_SAMPLE_RATE);
+                    success = false;
+                }
+                break;
+            }
+
             case 'v':
                 g_LogLevel = atoi(optarg);
                 break;
 
+            case 'x':
+                g_ExtremesFile = optarg;
+                break;
+
+            case 'o':
+                g_Observe = true;
+                break;
+
+            case Option_Pmin:
+                g_ObserveAttributes.pmin = atoi(optarg);
+                break;
+
+            case Option_Pmax:
+                g_ObserveAttributes.pmax = atoi(optarg);
+                break;
+
+            case Option_Step:
+                g_ObserveAttributes.step = atof(optarg);
+                break;
+
+            case 'f':
+                g_SpoolFile = optarg;
+                break;
+
+            case Option_Deadband:
+                success = deadbandConfigure(optarg) && success;
+                break;
+
+            case Option_Heartbeat: {
+                long heartbeatMs = parsePeriodMs(optarg);
+                deadbandSetHeartbeat(heartbeatMs);
+                success = success && heartbeatMs > 0;
+                break;
+            }
+
+            case Option_SpoolSize:
+                g_SpoolSize = strtoul(optarg, NULL, 10);
+                break;
+
+            case Option_History:
+                g_HistoryFile = optarg;
+                break;
+
+            case Option_HistorySize:
+                g_HistorySizeKb = strtoul(optarg, NULL, 10);
+                break;
+
+            case Option_Live:
+                g_LiveTable = optarg;
+                break;
+
+            case Option_Trace:
+                g_TraceFile = optarg;
+                break;
+
+            case Option_Replay:
+                g_ReplayFile = optarg;
+                break;
+
+            case Option_ReplayRepeat:
+                g_ReplayRepeat = atoi(optarg);
+                success = success && g_ReplayRepeat > 0;
+                break;
+
+            case Option_Deadline:
+                g_ReadDeadlineMs = parsePeriodMs(optarg);
+                success = success && g_ReadDeadlineMs > 0;
+                break;
+
+            case Option_Stats:
+                g_StatsFile = optarg;
+                break;
+
+            case Option_StatsInterval:
+                g_StatsIntervalMs = parsePeriodMs(optarg);
+                success = success && g_StatsIntervalMs > 0;
+                break;
+
+            case Option_StatsObject:
+                g_PublishStats = true;
+                break;
+
+            case 'n':
+                success = success && remoteNodesPin(optarg);
+                break;
+
+            case Option_Nodes:
+                g_NodesFile = optarg;
+                break;
+
+            case Option_Workers:
+                g_WorkerCount = atoi(optarg);
+                if (g_WorkerCount < 1 || g_WorkerCount > MAX_WORKER_COUNT) {
+                    LOG(LOG_ERROR, "Number of workers must be 1 to %d\n", MAX_WORKER_COUNT);
+                    success = false;
+                }
+                break;
+
+            case Option_NodeTimeout:
+                g_NodeTimeoutMs = parsePeriodMs(optarg);
+                success = success && g_NodeTimeoutMs > 0;
+                break;
+
+            case Option_Window:
+                g_RequestWindow = atoi(optarg);
+                if (g_RequestWindow < 1 || g_RequestWindow > AWA_REQUEST_WINDOW_MAX) {
+                    LOG(LOG_ERROR, "Window must be 1 to %d\n", AWA_REQUEST_WINDOW_MAX);
+                    success = false;
+                }
+                break;
+
             case 'h':
                 printUsage(argv[0]);
                 success = false;
@@ -180,294 +453,797 @@ bool loadConfiguration(int argc, char **argv) {
         }
     }
 
+    if (success && g_Observe && g_IfaceType != IfaceType_AwaLWM2M) {
+        LOG(LOG_ERROR, "Observing is supported only on AwaLWM2M interface\n");
+        success = false;
+    }
+    if (success && g_SampleRate > 0 && g_IfaceType != IfaceType_microBus) {
+        LOG(LOG_ERROR, "Sampling rate can be set only on microBus interface\n");
+        success = false;
+    }
+
     return success;
 }
 
-float readThermo3(uint8_t busIndex) {
-    LOG(LOG_DEBUG, "Reading thermo3 on bus#%d", busIndex);
-    float temperature = 0.f;
-    const AwaServerReadResponse *response;
-    const AwaFloat *value = NULL;
+uint8_t setMeasurement(SlotContext *slot, int objId, int instance, double value) {
+	if (g_SampleRate > 0) {
+		aggregatorAdd(&slot->aggregator, objId, instance, value);
+		return 0;
+	}
+	return pipelineSubmit(slot->producer, objId, instance, value) ? 0 : -1;
+}
 
-    if (g_IfaceType == IfaceType_AwaLWM2M) {
-        AwaServerReadOperation * operation = AwaServerReadOperation_New(g_server_session);
-        AwaServerReadOperation_AddPath(operation, CLIENT_ID, "/3303/0/5700");
-        if (AwaServerReadOperation_Perform(operation, EXTENDED_OPERATION_PERFORM_TIMEOUT) == AwaError_Success) {
-            response = AwaServerReadOperation_GetResponse(operation, CLIENT_ID);
-            if (response && AwaServerReadResponse_GetValueAsFloatPointer(response, "/3303/0/5700", &value)
-                    == AwaError_Success) {
-                temperature = (float)*value;
-                AwaServerReadOperation_Free(&operation);
+long slotDeadlineMs(const SlotContext *slot) {
+    return slot->sensor.periodMs < g_ReadDeadlineMs ? slot->sensor.periodMs : g_ReadDeadlineMs;
+}
+
+/** Reads of a quarantined click are skipped, it then holds neither the I2C bus nor its producer. */
+void measureSlot(SlotContext *slot) {
+    const SensorSlot *sensor = &slot->sensor;
+    double values[SENSOR_MAX_CHANNELS];
+    int index;
+
+    if (!breakerAllow(&slot->breaker)) {
+        return;
+    }
+    switch (sensorSlotRead(sensor, slotDeadlineMs(slot), values)) {
+        case SensorRead_Ok:
+            atomic_store(&slot->busBusy, 0);
+            break;
+        case SensorRead_BusBusy:
+            // the click never got to answer, the slot hogging the bus is quarantined by superviseSlots()
+            breakerCancel(&slot->breaker);
+            if (atomic_fetch_add(&slot->busBusy, 1) + 1 == BREAKER_THRESHOLD) {
+                LOG(LOG_ERROR, "%s degraded, the I2C bus stays held by another slot", slot->name);
             }
+            return;
+        default:
+            atomic_store(&slot->busBusy, 0);
+            breakerFailure(&slot->breaker, slot->name);
+            return;
+    }
+    breakerSuccess(&slot->breaker, slot->name);
+
+    for (index = 0; index < sensor->channelCount; index++) {
+        // not measured with the acquisition profile of the click
+        if (isnan(values[index])) {
+            continue;
         }
-    } else {
-        i2c_select_bus(busIndex);
+        setMeasurement(slot, sensor->channels[index].objectId, sensor->channels[index].instance, values[index]);
+    }
+}
+
+void publishAggregates(SlotContext *slot) {
+    int index;
+    Sample sample;
 
-        thermo3_click_enable(0);
-        thermo3_click_get_temperature(&temperature);
-        thermo3_click_disable();
+    for (index = 0; index < slot->aggregator.channelCount; index++) {
+        if (aggregateToSample(&slot->aggregator.channels[index], &sample)) {
+            LOG(LOG_INFO, "Window of /%d/%d: mean = %f, min = %f, max = %f, stddev = %f, samples = %u",
+                sample.objectId, sample.instance, sample.value, sample.min, sample.max, sample.stddev, sample.count);
+            pipelineSubmitSample(slot->producer, &sample);
+        }
     }
+    aggregatorReset(&slot->aggregator);
+}
 
-    return temperature;
+long slotPeriodMs(int index) {
+    return g_SlotPeriodMs[index] > 0 ? g_SlotPeriodMs[index] : g_PeriodMs;
 }
 
-float readCO(uint8_t busIndex) {
-    LOG(LOG_DEBUG, "Reading CO on bus#%d", busIndex);
-    uint16_t value = 0;
+void acquireSlot(Producer *producer, void *context) {
+    SlotContext *slot = (SlotContext *)context;
+    long periodMs = slotPeriodMs(slot->index);
 
-    co_click_get_measure(busIndex, &value);
+    slot->producer = producer;
+    measureSlot(slot);
+    if (g_SampleRate <= 0) {
+        return;
+    }
 
-    return value;
+    // windows follow each other without gaps, so they don't drift from the producer timer
+    int64_t now = schedulerNowMs();
+    if (slot->windowEnd == 0) {
+        slot->windowEnd = now + periodMs;
+    } else if (now >= slot->windowEnd) {
+        publishAggregates(slot);
+        while (slot->windowEnd <= now) {
+            slot->windowEnd += periodMs;
+        }
+    }
 }
 
-float readAirQuality(uint8_t busIndex) {
-    LOG(LOG_DEBUG, "Reading air quality on bus#%d", busIndex);
-    uint16_t value = 0;
+/** Event driven clicks publish every event straight away, even with a sampling rate set. */
+void acquireSlotEvents(Producer *producer, void *context) {
+    SlotContext *slot = (SlotContext *)context;
+    const SensorSlot *sensor = &slot->sensor;
+    double values[SENSOR_MAX_CHANNELS];
+    int index;
 
-    air_quality_click_get_measure(busIndex, &value);
+    slot->producer = producer;
+    if (!sensorSlotWaitEvent(sensor, EVENT_WAIT_TIMEOUT, values)) {
+        return;
+    }
+    for (index = 0; index < sensor->channelCount; index++) {
+        pipelineSubmit(producer, sensor->channels[index].objectId, sensor->channels[index].instance, values[index]);
+    }
+}
 
-    return value;
+/** Client side instance of /objId/instance of the node, every node gets its own block of instances. */
+int nodeInstance(const RemoteNode *node, int objId, int instance) {
+    return node->index * sensorObjectInstances(objId) + instance;
 }
 
-uint8_t readWeather(uint8_t busIndex, double* data) {
-	LOG(LOG_DEBUG, "Reading weather on bus#%d", busIndex);
+/** Perform function of a node read, relays the values through the worker performing it. */
+AwaError readNode(Producer *producer, AwaServerSession *session, void *context, int timeoutMs) {
+    RemoteNode *node = (RemoteNode *)context;
+    RemoteRead read = {NULL, NULL};
+    double values[SENSOR_MAX_CHANNELS];
+    int index;
+    int channel;
 
-	i2c_select_bus(busIndex);
-	if (weather_click_read_measurements(&data[0], &data[1], &data[2]) < 0) {
-		LOG(LOG_ERROR, "Reading weather measurements failed!");
-		return -1;
-	}
+    AwaError result = remoteReadPerform(&read, session, node->clientId, timeoutMs);
 
-	return 0;
+    // the clicks given for the slots are expected on every node
+    for (index = 0; index < SLOT_COUNT; index++) {
+        const SensorSlot *sensor = &g_Slots[index].sensor;
+        bool complete = true;
+
+        for (channel = 0; channel < sensor->channelCount && complete; channel++) {
+            complete = remoteReadGetValue(&read, sensor->channels[channel].valuePath, &values[channel]);
+        }
+        for (channel = 0; channel < sensor->channelCount && complete; channel++) {
+            int objId = sensor->channels[channel].objectId;
+            int instance = nodeInstance(node, objId, sensor->channels[channel].instance);
+            traceRead(objId, instance, values[channel]);
+            pipelineSubmit(producer, objId, instance, values[channel]);
+        }
+    }
+    remoteReadFinish(&read);
+    return result;
 }
 
-bool connectToAwa() {
-    g_ClientSession = AwaClientSession_New();
+void readNodeDone(void *context, AwaError result) {
+    RemoteNode *node = (RemoteNode *)context;
 
-    if (g_ClientSession != NULL) {
-        if (AwaClientSession_SetIPCAsUDP(g_ClientSession, "127.0.0.1", 12345) == AwaError_Success) {
-            if (AwaClientSession_Connect(g_ClientSession) == AwaError_Success) {
-                LOG(LOG_INFO, "Client Session Established: 127.0.0.1:12345\n");
-            } else {
-                LOG(LOG_ERROR, "AwaClientSession_Connect() failed\n");
-                AwaClientSession_Free(&g_ClientSession);
-                g_ClientSession = NULL;
-            }
-        } else {
-            LOG(LOG_ERROR, "AwaClientSession_SetIPCAsUDP() failed\n");
-            AwaClientSession_Free(&g_ClientSession);
-            g_ClientSession = NULL;
-        }
+    if (result != AwaError_Success && result != AwaError_Response) {
+        atomic_fetch_add(&node->failures, 1);
+        breakerFailure(&node->breaker, node->clientId);
     } else {
-        LOG(LOG_ERROR, "AwaClientSession_New() failed\n");
+        breakerSuccess(&node->breaker, node->clientId);
+    }
+    atomic_store(&node->pending, false);
+}
+
+/**
+ * Submit read of every registered node not pending since an earlier period. Nodes left out while the window is full
+ * wait for the next period and go first then, so a slow daemon or node never makes reads queue up.
+ */
+void pollNodes(void) {
+    static int first = 0;
+    int count = remoteNodesCount();
+    int index;
+
+    for (index = 0; index < count; index++) {
+        RemoteNode *node = remoteNodesGet((first + index) % count);
+
+        if (!atomic_load(&node->registered) || atomic_load(&node->pending) || !breakerAllow(&node->breaker)) {
+            continue;
+        }
+
+        AwaRequest request = {&readNode, &readNodeDone, node, &node->rtt};
+        atomic_store(&node->pending, true);
+        if (!awaRequestSubmit(&request)) {
+            breakerCancel(&node->breaker);
+            atomic_store(&node->pending, false);
+            LOG(LOG_DEBUG, "Request window full, %s is read next period", node->clientId);
+            first = node->index;
+            return;
+        }
+        atomic_fetch_add(&node->reads, 1);
+    }
+}
+
+/** Follows nodes registering with the server and hands reads of them to the workers every period. */
+void acquireDiscovery(Producer *producer, void *context) {
+    int64_t now = schedulerNowMs();
+    int timeoutMs = now < g_NextPollMs ? (int)(g_NextPollMs - now) : 0;
+
+    (void)producer;
+    (void)context;
+
+    if (timeoutMs > DISCOVERY_PROCESS_TIMEOUT) {
+        timeoutMs = DISCOVERY_PROCESS_TIMEOUT;
+    }
+    if (AwaServerSession_Process(g_server_session, timeoutMs) != AwaError_Success) {
+        schedulerSleepMs(timeoutMs);
+    }
+    AwaServerSession_DispatchCallbacks(g_server_session);
+    remoteNodesMaintain(g_server_session);
+
+    now = schedulerNowMs();
+    if (now >= g_NextPollMs) {
+        // periods missed while the server session was busy are skipped, not made up for
+        g_NextPollMs = now - g_NextPollMs < g_PeriodMs ? g_NextPollMs + g_PeriodMs : now + g_PeriodMs;
+        pollNodes();
+    }
+}
+
+void relayMeasurement(void *context, int objId, int instance, double value) {
+    const RemoteNode *node = (const RemoteNode *)context;
+    traceRead(objId, nodeInstance(node, objId, instance), value);
+    pipelineSubmit(g_RemoteProducer, objId, nodeInstance(node, objId, instance), value);
+}
+
+/** Observes nodes as they register, notifications of all of them arrive through the one server session. */
+void acquireObservedNodes(Producer *producer, void *context) {
+    int index;
+    RemoteNode *node;
+
+    (void)context;
+    g_RemoteProducer = producer;
+    for (index = 0; (node = remoteNodesGet(index)) != NULL; index++) {
+        bool registered = atomic_load(&node->registered);
+
+        if (registered && !node->observed && schedulerNowMs() >= node->observeRetryMs) {
+            node->observed = remoteObserveStart(g_server_session, node->clientId, node);
+            node->observeRetryMs = schedulerNowMs() + g_PeriodMs;
+        } else if (!registered && node->observed) {
+            remoteObserveCancel(g_server_session, node->clientId);
+            node->observed = false;
+        }
+    }
+    remoteObserveProcess(g_server_session);
+    remoteNodesMaintain(g_server_session);
+}
+
+bool publishSamples(const Sample *samples, int count) {
+    int index;
+    AwaClientSession *session = awaSessionAcquire();
+    if (session == NULL) {
+        return false;
+    }
+
+    for (index = 0; index < count; index++) {
+        batchAddMeasurement(samples[index].objectId, samples[index].instance, samples[index].value,
+                            samples[index].min, samples[index].max);
+    }
+    return awaSessionReportResult(batchFlush(session));
+}
+
+/**
+ * Publish spooled samples keeping every one of them, unlike a cycle batch which keeps the latest value of each
+ * instance. The batch is flushed before it would take a second value of an instance, each flush carries one sample per
+ * instance in the order they were taken.
+ */
+bool publishReplayed(const Sample *samples, int count) {
+    int index;
+    AwaClientSession *session = awaSessionAcquire();
+    if (session == NULL) {
+        return false;
+    }
+
+    for (index = 0; index < count; index++) {
+        if (batchPending(samples[index].objectId, samples[index].instance) &&
+            !awaSessionReportResult(batchFlush(session))) {
+            return false;
+        }
+        batchAddMeasurement(samples[index].objectId, samples[index].instance, samples[index].value,
+                            samples[index].min, samples[index].max);
+    }
+    return awaSessionReportResult(batchFlush(session));
+}
+
+void spoolSamples(const Sample *samples, int count) {
+    int index;
+    bool lost = false;
+    int64_t start = statsStart();
+
+    for (index = 0; index < count; index++) {
+        if (!spoolAppend(&samples[index])) {
+            LOG(LOG_WARN, "Sample of /%d/%d lost", samples[index].objectId, samples[index].instance);
+            lost = true;
+        }
     }
-    return g_ClientSession != NULL;
+    spoolSync();
+    statsRecord(StatsStage_SpoolWrite, start, lost ? StatsOutcome_Error : StatsOutcome_Ok);
 }
 
-void disconnectAwa() {
-    if (g_ClientSession == NULL) {
+/** Objects and instances are set up on every connect, the client daemon forgets them when it restarts. */
+AwaError prepareClient(AwaClientSession *session) {
+    AwaError result = ipsoDefineObjects(session);
+    return result == AwaError_Success ? ipsoCreateInstances(session, g_PublishStats) : result;
+}
+
+/**
+ * Publish samples collected in the cycle started at start. A bounded part of the backlog is replayed first, the cycle
+ * itself is published right after it, so current values don't wait for the whole backlog.
+ */
+void publishCollected(int64_t start) {
+    int batches;
+
+    // backlog goes out first, so the newest values are the ones left in the daemon
+    for (batches = 0; batches < MAX_REPLAY_BATCHES_PER_CYCLE && spoolPending() > 0; batches++) {
+        int64_t replayStart = statsStart();
+        int replayed = spoolReplay(&publishReplayed);
+        statsRecord(StatsStage_SpoolReplay, replayStart, replayed < 0 ? StatsOutcome_Error : StatsOutcome_Ok);
+        if (replayed <= 0) {
+            break;
+        }
+    }
+
+    if (g_CycleSampleCount == 0) {
         return;
     }
-    AwaClientSession_Disconnect(g_ClientSession);
-    AwaClientSession_Free(&g_ClientSession);
+    if (!publishSamples(g_CycleSamples, g_CycleSampleCount)) {
+        awaSessionDropCycle();
+        spoolSamples(g_CycleSamples, g_CycleSampleCount);
+    }
+    statsRecord(StatsStage_PublishCycle, start, StatsOutcome_Ok);
 }
 
-void createIPSO(int objectId, int instance, int resourceId) {
-    AwaClientSetOperation * operation = AwaClientSetOperation_New(g_ClientSession);
+void collectSample(const Sample *sample) {
+    int64_t timeMs = (int64_t)sample->timestamp.tv_sec * 1000 + sample->timestamp.tv_nsec / 1000000;
 
-    char buf[40];
-    if (resourceId == -1) {
-        sprintf(&buf[0], "/%d/%d", objectId, instance);
-        AwaClientSetOperation_CreateObjectInstance(operation, &buf[0]);
+    // local consumers get every sample, deadband only spares the uplink
+    historyAppend(sample->objectId, sample->instance, timeMs, sample->value);
+    liveValuesUpdate(sample->objectId, sample->instance, timeMs, sample->value, sample->min, sample->max);
 
-    } else {
-        sprintf(&buf[0], "/%d/%d/%d", objectId, instance, resourceId);
-        LOG(LOG_INFO, "Creating instance of resource %s", &buf[0]);
-        AwaClientSetOperation_CreateOptionalResource(operation, &buf[0]);
-    }
-
-    AwaError result = AwaClientSetOperation_Perform(operation, OPERATION_PERFORM_TIMEOUT);
-    LOG(LOG_DEBUG, "Awa create response: %d", result);
-    AwaClientSetOperation_Free(&operation);
-}
-
-void setIPSO(int objectId, int instance, int resourceId, float value, bool shouldRetry) {
-    char buf[40];
-    sprintf(&buf[0], "/%d/%d/%d", objectId, instance, resourceId);
-    LOG(LOG_INFO, "Storing value %0.3f into %s", value, &buf[0]);
-    AwaClientSetOperation* operation = AwaClientSetOperation_New(g_ClientSession);
-    AwaClientSetOperation_AddValueAsFloat(operation, &buf[0], value);
-    AwaError result = AwaClientSetOperation_Perform(operation, OPERATION_PERFORM_TIMEOUT);
-    LOG(LOG_DEBUG, "Awa set response: %d", result);
-    if (result == AwaError_Response || result == AwaError_PathInvalid || result == AwaError_PathNotFound) {
-        LOG(LOG_DEBUG, "Looks like instance of %s not exists, try to create one", &buf[0]);
-        if (shouldRetry == true) {
-            createIPSO(objectId, instance, -1);
-            createIPSO(objectId, instance, resourceId);
-            setIPSO(objectId, instance, resourceId, value, false);
+    // new extremes have to reach 5601/5602 even when the value itself stays within its deadband
+    bool force = extremesExtended(sample->objectId, sample->instance, sample->min, sample->max);
+    if (deadbandPass(sample->objectId, sample->instance, sample->value, schedulerNowMs(), force)) {
+        if (g_CycleSampleCount == CYCLE_SAMPLES_CAPACITY) {
+            // more samples than one batch holds, what was collected goes out ahead of the cycle
+            publishCollected(statsStart());
+            g_CycleSampleCount = 0;
         }
+        g_CycleSamples[g_CycleSampleCount++] = *sample;
     }
 }
 
-float getIPSO(int objectId, int instance, int resourceId, float defaultValue) {
-    char buf[40];
-    sprintf(&buf[0], "/%d/%d/%d", objectId, instance, resourceId);
-    LOG(LOG_DEBUG, "Getting value of %s", &buf[0]);
-    AwaClientGetOperation * operation = AwaClientGetOperation_New(g_ClientSession);
+/** A slot stuck in a read can't report itself, the publisher quarantines it once it is past its deadline. */
+void superviseSlots() {
+    int index;
 
-    AwaClientGetOperation_AddPath(operation, &buf[0]);
-    AwaError result = AwaClientGetOperation_Perform(operation, OPERATION_PERFORM_TIMEOUT);
-    if (result != AwaError_Success) {
-        AwaClientGetOperation_Free(&operation);
-        return defaultValue;
+    if (g_IfaceType != IfaceType_microBus) {
+        return;
+    }
+    for (index = 0; index < SLOT_COUNT; index++) {
+        SlotContext *slot = &g_Slots[index];
+        if (sensorSlotSampled(&slot->sensor)) {
+            breakerTripHung(&slot->breaker, slotDeadlineMs(slot), slot->name);
+        }
     }
+}
+
+void publishMeasurements() {
+    superviseSlots();
+    g_CycleSampleCount = 0;
+    if (pipelineWait(PUBLISH_WAIT_TIMEOUT)) {
+        pipelineDrain(&collectSample);
+        historyCheckpoint(false);
+    }
+    traceCycle();
+    publishCollected(statsStart());
+}
 
-    const AwaFloat* value;
-    float resultValue;
+/** Client daemon operations, the IPC the replay accounts per sample. */
+static bool clientStage(int stage) {
+    return stage == StatsStage_ExtremesGet || stage == StatsStage_Publish || stage == StatsStage_Create ||
+        stage == StatsStage_Connect;
+}
 
-    const AwaClientGetResponse* response = AwaClientGetOperation_GetResponse(operation);
-    AwaClientGetResponse_GetValueAsFloatPointer(response, (const char*)&buf[0], &value);
-    resultValue = (float)*value;
-    LOG(LOG_DEBUG, "Got value %f\n", (float)resultValue);
+static unsigned long clientOps(void) {
+    unsigned long ops = 0;
+    int stage;
 
-    AwaClientGetOperation_Free(&operation);
-    return resultValue;
+    for (stage = 0; stage < StatsStage_Count; stage++) {
+        ops += clientStage(stage) ? statsCount(stage) : 0;
+    }
+    return ops;
 }
 
-uint8_t setMeasurement(int objId, int instance, double value) {
+void replayRead(int objectId, int instance, double value) {
+    int index;
 
-	float minValue = getIPSO(objId, instance, 5601, 1000);
-	float maxValue = getIPSO(objId, instance, 5602, -1000);
+    for (index = 0; index < g_ReplayChannelCount; index++) {
+        if (g_ReplayChannels[index].objectId == objectId && g_ReplayChannels[index].instance == instance) {
+            break;
+        }
+    }
+    if (index == g_ReplayChannelCount) {
+        if (g_ReplayChannelCount == REPLAY_MAX_CHANNELS) {
+            return;
+        }
+        g_ReplayChannels[index].objectId = objectId;
+        g_ReplayChannels[index].instance = instance;
+        g_ReplayChannels[index].count = 0;
+        g_ReplayChannelCount++;
+    }
+    aggregateAdd(&g_ReplayChannels[index], value);
+}
 
-	setIPSO(objId, instance, 5700, value, true);
-	if (minValue > value) {
-		setIPSO(objId, instance, 5601, value, true);
-	}
-	if (maxValue < value) {
-		setIPSO(objId, instance, 5602, value, true);
-	}
-	return 0;
+/** Reads since the last cycle are aggregated per channel, as producers sampling at a rate do it. */
+int replayCycle(int64_t timeMs) {
+    int index;
+    int samples = 0;
+    Sample sample;
+    int64_t start = statsStart();
+
+    g_CycleSampleCount = 0;
+    for (index = 0; index < g_ReplayChannelCount; index++) {
+        if (aggregateToSample(&g_ReplayChannels[index], &sample)) {
+            sample.timestamp.tv_sec = timeMs / 1000;
+            sample.timestamp.tv_nsec = (timeMs % 1000) * 1000000;
+            collectSample(&sample);
+            samples++;
+        }
+        g_ReplayChannels[index].count = 0;
+    }
+    publishCollected(start);
+    return samples;
 }
 
-void handleMeasurements(uint8_t bus, int objId, int instance, SensorReadFunc sensorFunc) {
-    float value = sensorFunc(bus);
-    setMeasurement(objId, instance, value);
+/**
+ * Feed the trace through the publishing path in virtual time, as fast as it goes. Repeated passes continue where
+ * the previous one ended, in time and in the published values.
+ */
+bool replayTrace(const char *path, int repeat) {
+    TraceRecord record;
+    int64_t traceStartMs;
+    uint32_t lengthMs = 0;
+    unsigned long cycles = 0;
+    unsigned long samples = 0;
+    unsigned long recordedOps = 0;
+    unsigned long recordedSamples = 0;
+    int round;
+
+    if (!traceReplayOpen(path, &traceStartMs)) {
+        return false;
+    }
+
+    int64_t virtualStartMs = schedulerNowMs();
+    unsigned long opsBefore = clientOps();
+    int64_t start = statsStart();
+    for (round = 0; round < repeat && g_Running; round++) {
+        int64_t offsetMs = (int64_t)round * (lengthMs + 1);
+
+        traceReplayRewind();
+        while (traceReplayNext(&record) && g_Running) {
+            schedulerSetVirtualMs(virtualStartMs + offsetMs + record.timeMs);
+            if (round == 0 && record.timeMs > lengthMs) {
+                lengthMs = record.timeMs;
+            }
+
+            if (record.type == TraceRecord_Read) {
+                replayRead(record.objectId, record.instance, record.value);
+            } else if (record.type == TraceRecord_Cycle) {
+                int cycleSamples = replayCycle(traceStartMs + offsetMs + record.timeMs);
+                samples += cycleSamples;
+                recordedSamples += round == 0 ? cycleSamples : 0;
+                cycles++;
+            } else if (record.type == TraceRecord_Stage && round == 0 && clientStage(record.objectId)) {
+                recordedOps++;
+            }
+        }
+    }
+    traceReplayClose();
+
+    double seconds = (statsStart() - start) / 1e6;
+    double traceSeconds = (double)round * (lengthMs + 1) / 1000;
+    unsigned long ops = clientOps() - opsBefore;
+    printf("Replayed %lu cycles with %lu samples, %.1f s of trace in %.3f s (%.0fx real time)\n"
+           "cycles/s=%.0f ipcOpsPerSample=%.3f (recorded %.3f) cycleP50=%.3fms cycleP99=%.3fms\n",
+           cycles, samples, traceSeconds, seconds, seconds > 0 ? traceSeconds / seconds : 0,
+           seconds > 0 ? cycles / seconds : 0, samples > 0 ? (double)ops / samples : 0,
+           recordedSamples > 0 ? (double)recordedOps / recordedSamples : 0,
+           statsPercentileMs(StatsStage_PublishCycle, 0.5), statsPercentileMs(StatsStage_PublishCycle, 0.99));
+    fflush(stdout);
+    return true;
 }
 
+static void formatCounters(char *line, size_t size) {
+    const AwaSessionStats *session = awaSessionGetStats();
+    const DeadbandStats *deadband = deadbandGetStats();
 
-void handleWeatherMeasurements(uint8_t busIndex,
-		int temperatureInstance, int pressureInstance, int humidityInstance) {
+    snprintf(line, size, "overruns=%lu droppedSamples=%lu reconnects=%lu droppedCycles=%lu sent=%lu suppressed=%lu"
+             " spooled=%u logDropped=%lu", pipelineOverruns(), pipelineDroppedSamples(), session->reconnects,
+             session->droppedCycles, deadband->sent, deadband->suppressed, spoolPending(), logDropped());
+}
 
-	double data[] = {0,0,0};
-    if (readWeather(busIndex, data) < 0) {
-    	LOG(LOG_ERROR, "Reading weather on bus#%d failed!", busIndex);
-    	return;
+static bool formatNodes(char *line, size_t size) {
+    unsigned long reads = 0;
+    unsigned long failures = 0;
+    int registered = 0;
+    int index;
+    RemoteNode *node;
+
+    if (g_IfaceType != IfaceType_AwaLWM2M) {
+        return false;
+    }
+    for (index = 0; (node = remoteNodesGet(index)) != NULL; index++) {
+        registered += atomic_load(&node->registered) ? 1 : 0;
+        reads += atomic_load(&node->reads);
+        failures += atomic_load(&node->failures);
     }
-    LOG(LOG_INFO, "Reading weather measurements: temp = %f, pressure = %f, humidity = %f",
-    			data[0], data[1], data[2]);
-    setMeasurement(3303, temperatureInstance, data[0]);
-    setMeasurement(3315, pressureInstance, data[1]);
-    setMeasurement(3304, humidityInstance, data[2]);
+    AwaRequestStats requests;
+    awaRequestGetStats(&requests);
+    snprintf(line, size, "nodes known=%d registered=%d reads=%lu failures=%lu timeouts=%lu deferred=%lu"
+             " outstanding=%d", remoteNodesCount(), registered, reads, failures, requests.timedOut, requests.rejected,
+             requests.outstanding);
+    return true;
 }
 
-void performMeasurements() {
-    if (connectToAwa() == false) {
-        return;
+static bool formatHistory(char *line, size_t size) {
+    HistoryStats history;
+
+    if (g_HistorySizeKb == 0) {
+        return false;
     }
+    historyGetStats(&history);
+    snprintf(line, size, "history channels=%d samples=%lu bytes=%lu blocks=%d/%d evicted=%lu", history.series,
+             history.samples, history.bytes, history.blocks, history.capacity, history.evicted);
+    return true;
+}
 
+/** Clicks and nodes which are quarantined or hung in a read right now, and how often breakers tripped so far. */
+static bool formatHealth(char *line, size_t size) {
+    unsigned long trips = 0;
+    int unhealthy = 0;
     int index;
-    int instanceIndex[] = {0,		//3303 - temperature
-						   1, 		//3304 - humidity
-						   2,		//3315 - barometer
-						   3,		//3325 - concentration
-						   4,		//3330 - distance
-						   5};		//3328 - power
-
-    //contains last used instance ids for all registered sensors
-    int instances[] = {0,	//3303
-					   0,	//3304
-					   0,	//3315
-					   0,	//3325
-					   0,	//3330
-					   0};	//3328
-
-    for (index = 0; index < 2; index++) {
-        uint8_t bus = index == 0 ? MIKROBUS_1 : MIKROBUS_2;
-
-        switch (index == 0 ? g_Click1Type : g_Click2Type) {
-            case ClickType_Thermo3:
-            	handleMeasurements(bus, 3303, instances[instanceIndex[0]]++, &readThermo3);
-
-                break;
-
-            case ClickType_Weather:
-            	handleWeatherMeasurements(bus,
-            			instances[instanceIndex[0]]++,
-						instances[instanceIndex[1]]++,
-						instances[instanceIndex[2]]++);
-
-            	break;
-            case ClickType_Thunder:
-            	break;
-            case ClickType_AirQuality:
-            	handleMeasurements(bus, 3325, instances[instanceIndex[3]]++, &readAirQuality);
-            	break;
-            case ClickType_CODetector:
-            	handleMeasurements(bus, 3325, instances[instanceIndex[3]]++, &readCO);
-                break;
-            default:
-                break;
+    RemoteNode *node;
+
+    if (g_IfaceType == IfaceType_AwaLWM2M) {
+        if (g_Observe) {
+            return false;
+        }
+        for (index = 0; (node = remoteNodesGet(index)) != NULL; index++) {
+            unhealthy += breakerHealthy(&node->breaker, g_NodeTimeoutMs + g_PeriodMs) ? 0 : 1;
+            trips += atomic_load(&node->breaker.trips);
+        }
+        snprintf(line, size, "health nodes=%d unhealthy=%d trips=%lu", remoteNodesCount(), unhealthy, trips);
+        return true;
+    }
+
+    int length = snprintf(line, size, "health");
+    for (index = 0; index < SLOT_COUNT; index++) {
+        const SlotContext *slot = &g_Slots[index];
+
+        if (sensorSlotSampled(&slot->sensor) && length < (int)size) {
+            // a slot which can't get the bus is not at fault, but it isn't reporting either
+            length += snprintf(line + length, size - length, " slot%d=%s", index + 1,
+                               atomic_load(&slot->busBusy) >= BREAKER_THRESHOLD ? "degraded" :
+                               breakerDescribe(&slot->breaker, slotDeadlineMs(slot)));
+            trips += atomic_load(&slot->breaker.trips);
+        }
+    }
+    if (length < (int)size) {
+        snprintf(line + length, size - length, " trips=%lu", trips);
+    }
+    return true;
+}
+
+static bool formatThunder(char *line, size_t size) {
+    const ThunderStats *thunder = thunderGetStats();
+    int index;
+
+    for (index = 0; index < SLOT_COUNT && !sensorSlotEventDriven(&g_Slots[index].sensor); index++);
+    if (index == SLOT_COUNT || g_IfaceType != IfaceType_microBus) {
+        return false;
+    }
+    snprintf(line, size, "thunder strikes=%lu lastMinute=%d lastHour=%d interrupts=%lu disturbers=%lu noise=%lu"
+             " masked=%lu noiseFloor=%d", thunder->strikes, thunderStrikesWithin(60000), thunderStrikesWithin(3600000),
+             thunder->interrupts, thunder->disturbers, thunder->noise, thunder->masked, thunder->noiseFloor);
+    return true;
+}
+
+static void dumpStats() {
+    char line[STATS_LINE_SIZE];
+    int stage;
+
+    formatCounters(line, sizeof(line));
+    LOG(LOG_INFO, "Stats: %s", line);
+    if (formatNodes(line, sizeof(line))) {
+        LOG(LOG_INFO, "Stats: %s", line);
+    }
+    if (formatHealth(line, sizeof(line))) {
+        LOG(LOG_INFO, "Stats: %s", line);
+    }
+    if (formatThunder(line, sizeof(line))) {
+        LOG(LOG_INFO, "Stats: %s", line);
+    }
+    if (formatHistory(line, sizeof(line))) {
+        LOG(LOG_INFO, "Stats: %s", line);
+    }
+    for (stage = 0; stage < StatsStage_Count; stage++) {
+        if (statsFormatStage(stage, line, sizeof(line))) {
+            LOG(LOG_INFO, "Stats: %s", line);
         }
     }
+}
+
+static void writeStatsFile(const char *path) {
+    char line[STATS_LINE_SIZE];
+    char tmpPath[256];
+
+    // readers never see a half written file
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    FILE *file = fopen(tmpPath, "w");
+    if (file == NULL) {
+        LOG(LOG_ERROR, "Can't open %s for writing", tmpPath);
+        return;
+    }
+    formatCounters(line, sizeof(line));
+    fprintf(file, "%s\n", line);
+    if (formatNodes(line, sizeof(line))) {
+        fprintf(file, "%s\n", line);
+    }
+    if (formatHealth(line, sizeof(line))) {
+        fprintf(file, "%s\n", line);
+    }
+    if (formatThunder(line, sizeof(line))) {
+        fprintf(file, "%s\n", line);
+    }
+    if (formatHistory(line, sizeof(line))) {
+        fprintf(file, "%s\n", line);
+    }
+    statsWrite(file);
+    fclose(file);
+    if (rename(tmpPath, path) != 0) {
+        LOG(LOG_ERROR, "Can't write stats to %s", path);
+    }
+}
+
+void reportStats() {
+    static int64_t nextReportMs = 0;
+    int64_t now = schedulerNowMs();
+
+    if (statsDumpRequested()) {
+        dumpStats();
+    }
+    if (nextReportMs == 0) {
+        nextReportMs = now + g_StatsIntervalMs;
+    }
+    if (now < nextReportMs) {
+        return;
+    }
+    nextReportMs = now + g_StatsIntervalMs;
 
-    disconnectAwa();
+    if (g_StatsFile[0] != '\0') {
+        writeStatsFile(g_StatsFile);
+    }
+    if (g_PublishStats) {
+        AwaClientSession *session = awaSessionAcquire();
+        if (session != NULL) {
+            awaSessionReportResult(statsPublish(session));
+        }
+    }
 }
 
 static void disconnectExtendedAwa()
 {
+    if (g_server_session == NULL) {
+        return;
+    }
+    remoteObserveStop(g_server_session);
     AwaServerSession_Disconnect(g_server_session);
     AwaServerSession_Free(&g_server_session);
 }
 
 void cleanupOnExit() {
-    i2c_release();
-    disconnectAwa();
+    int index;
+    bool stopped = pipelineStop();
+
+    // samples producers queued after the last cycle go to the spool, the next run publishes them
+    g_CycleSampleCount = 0;
+    pipelineDrain(&collectSample);
+    if (g_CycleSampleCount > 0) {
+        spoolSamples(g_CycleSamples, g_CycleSampleCount);
+    }
+
+    if (g_StatsFile[0] != '\0') {
+        writeStatsFile(g_StatsFile);
+    }
+    extremesCheckpoint(true);
+    spoolClose();
+    historyClose();
+    liveValuesClose();
+    awaSessionClose();
+    if (!stopped) {
+        // a producer still holds its device or server session, leave them to the exit
+        return;
+    }
+    if (g_IfaceType == IfaceType_microBus) {
+        for (index = 0; index < SLOT_COUNT; index++) {
+            sensorSlotRelease(&g_Slots[index].sensor);
+        }
+        i2c_release();
+    }
+    for (index = 0; index < g_WorkerCount; index++) {
+        awaRequestWorkerClose(&g_Workers[index]);
+    }
     disconnectExtendedAwa();
+    traceClose();
+}
+
+static void stopOnSignal(int signalNumber) {
+    (void)signalNumber;
+    g_Running = 0;
+}
+
+static void dumpStatsOnSignal(int signalNumber) {
+    (void)signalNumber;
+    statsRequestDump();
+}
+
+void attachSlots() {
+	int index;
+	int channel;
+
+	// instance ids follow slot order, so they stay the same for the same clicks
+	for (index = 0; index < SLOT_COUNT; index++) {
+		SensorSlot *sensor = &g_Slots[index].sensor;
+
+		sensorSlotAttach(sensor, g_SlotTypes[index], index == 0 ? MIKROBUS_1 : MIKROBUS_2);
+		sensor->profile = g_SlotProfiles[index];
+		sensor->periodMs = g_SampleRate > 0 ? (long)(1000 / g_SampleRate) : slotPeriodMs(index);
+		snprintf(g_Slots[index].name, sizeof(g_Slots[index].name), "%s@slot%d",
+		         sensor->type != NULL ? sensor->type->name : "none", index + 1);
+		for (channel = 0; channel < sensor->channelCount; channel++) {
+			batchRegisterChannel(sensor->channels[channel].objectId, sensor->channels[channel].instance,
+			                     sensor->channels[channel].units);
+		}
+	}
 }
 
 void initialize() {
 	int index;
-	for (index = 0; index < 2; index++) {
-		uint8_t bus = index == 0 ? MIKROBUS_1 : MIKROBUS_2;
-
-		switch (index == 0 ? g_Click1Type : g_Click2Type) {
-		case ClickType_Thermo3:
-			break;
-		case ClickType_Weather:
-			i2c_select_bus(index);
-			if (weather_click_enable() < 0) {
-				LOG(LOG_ERROR, "Failed to enable weather click on bus#%d\n", index);
-			}
-			break;
-
-			//TODO: add rest if needed
-		default:
-			break;
+	for (index = 0; index < SLOT_COUNT; index++) {
+		sensorSlotInit(&g_Slots[index].sensor);
+	}
+}
+
+void initializeRemote() {
+	int index;
+	int channel;
+	for (index = 0; index < SLOT_COUNT; index++) {
+		const SensorSlot *sensor = &g_Slots[index].sensor;
+
+		for (channel = 0; channel < sensor->channelCount; channel++) {
+			remoteReadRequireObject(sensor->channels[channel].objectId);
+			remoteObserveAdd(sensor->channels[channel].objectId, sensor->channels[channel].instance);
 		}
 	}
+	remoteObserveConfigure(&g_ObserveAttributes, &relayMeasurement);
+	remoteNodesSetTimeout(g_NodeTimeoutMs);
+	remoteNodesLoad(g_NodesFile);
 }
 
+/**
+ * Connect the discovery session, retrying with exponential backoff for up to SERVER_CONNECT_DEADLINE ms. Gives up
+ * earlier when the station is asked to stop.
+ */
 bool initialize_extended_awa()
 {
+    int64_t deadline = schedulerNowMs() + SERVER_CONNECT_DEADLINE;
+    long backoffMs = RECONNECT_BACKOFF_MIN_MS;
+
     g_server_session = AwaServerSession_New();
-    if (g_server_session) {
-        while(AwaServerSession_Connect(g_server_session) != AwaError_Success) {
-            sleep(g_SleepTime);
+    if (g_server_session == NULL) {
+        return false;
+    }
+    while (AwaServerSession_Connect(g_server_session) != AwaError_Success) {
+        int64_t now = schedulerNowMs();
+        if (!g_Running || now >= deadline) {
+            LOG(LOG_ERROR, "Can't connect to the Awa server daemon");
+            AwaServerSession_Free(&g_server_session);
+            return false;
         }
-        return true;
+        LOG(LOG_WARN, "Awa server daemon not reachable, next attempt in %ld ms", backoffMs);
+        schedulerSleepMs(now + backoffMs < deadline ? backoffMs : deadline - now);
+        backoffMs = backoffMs * 2 < RECONNECT_BACKOFF_MAX_MS ? backoffMs * 2 : RECONNECT_BACKOFF_MAX_MS;
     }
-
-    return false;
+    return true;
 }
 
 int main(int argc, char **argv) {
@@ -475,27 +1251,74 @@ int main(int argc, char **argv) {
         return -1;
     }
 
-    signal(SIGINT, &cleanupOnExit);
+    logStart();
+    atexit(&logStop);
+    // leave the main loop so that exit handlers run, with the spool and extremes stored
+    signal(SIGINT, &stopOnSignal);
+    signal(SIGTERM, &stopOnSignal);
+    signal(SIGUSR1, &dumpStatsOnSignal);
     atexit(&cleanupOnExit);
+    extremesLoad(g_ExtremesFile);
+    if (g_SpoolSize > 0) {
+        spoolOpen(g_SpoolFile, g_SpoolSize);
+    }
+    if (g_HistorySizeKb > 0) {
+        historyOpen(g_HistoryFile, g_HistorySizeKb);
+    }
+    if (g_LiveTable[0] != '\0' && !liveValuesOpen(g_LiveTable)) {
+        LOG(LOG_ERROR, "Can't open shared memory %s for latest values", g_LiveTable);
+    }
+    attachSlots();
+    awaSessionSetPrepare(&prepareClient);
+    if (g_TraceFile != NULL) {
+        traceOpen(g_TraceFile);
+    }
+    if (g_ReplayFile != NULL) {
+        return replayTrace(g_ReplayFile, g_ReplayRepeat) ? 0 : 1;
+    }
 
+    static const char *slotNames[SLOT_COUNT] = {"slot1", "slot2"};
+    int index;
     switch (g_IfaceType) {
         case IfaceType_microBus:            
             i2c_init();
             initialize();
+            for (index = 0; index < SLOT_COUNT; index++) {
+                if (sensorSlotSampled(&g_Slots[index].sensor)) {
+                    pipelineStartProducer(slotNames[index], &acquireSlot, &g_Slots[index],
+                            g_Slots[index].sensor.periodMs);
+                } else if (sensorSlotEventDriven(&g_Slots[index].sensor)) {
+                    pipelineStartProducer(slotNames[index], &acquireSlotEvents, &g_Slots[index], 0);
+                }
+            }
             break;
         case IfaceType_AwaLWM2M:
             if (!initialize_extended_awa()) {
                     return 1;
             }
+            initializeRemote();
+            remoteNodesWatch(g_server_session);
+            if (g_Observe) {
+                pipelineStartProducer("observer", &acquireObservedNodes, NULL, 0);
+                break;
+            }
+            static const char *workerNames[MAX_WORKER_COUNT] = {"worker1", "worker2", "worker3"};
+            awaRequestSetWindow(g_RequestWindow);
+            g_NextPollMs = schedulerNowMs();
+            pipelineStartProducer("discovery", &acquireDiscovery, NULL, 0);
+            for (index = 0; index < g_WorkerCount; index++) {
+                pipelineStartProducer(workerNames[index], &awaRequestWork, &g_Workers[index], 0);
+            }
             break;
         default:
             return 1;
     }
 
-    while(true) {
-        performMeasurements();
-        sleep(g_SleepTime);
+    while(g_Running) {
+        publishMeasurements();
+        reportStats();
     }
 
+    LOG(LOG_INFO, "Stopping");
     return 0;
 }
@@ -0,0 +1,163 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "extremes.h"
+#include "log.h"
+
+static Extremes table[EXTREMES_MAX_ENTRIES];
+static int tableSize = 0;
+static const char *checkpointPath = NULL;
+static bool dirty = false;
+static time_t lastCheckpoint = 0;
+
+static Extremes *addEntry(int objectId, int instance) {
+    if (tableSize >= EXTREMES_MAX_ENTRIES) {
+        return NULL;
+    }
+
+    Extremes *extremes = &table[tableSize++];
+    memset(extremes, 0, sizeof(*extremes));
+    extremes->objectId = objectId;
+    extremes->instance = instance;
+    return extremes;
+}
+
+bool extremesLoad(const char *path) {
+    int objectId, instance;
+    float min, max;
+
+    checkpointPath = path;
+    lastCheckpoint = time(NULL);
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        LOG(LOG_INFO, "No extremes checkpoint in %s, starting fresh", path);
+        return true;
+    }
+
+    while (fscanf(file, "%d %d %f %f", &objectId, &instance, &min, &max) == 4) {
+        Extremes *extremes = extremesLookup(objectId, instance);
+        if (extremes == NULL) {
+            break;
+        }
+        extremes->min = min;
+        extremes->max = max;
+        extremes->valid = true;
+        extremes->seeded = true;
+        extremes->minPending = true;
+        extremes->maxPending = true;
+    }
+
+    LOG(LOG_INFO, "Loaded %d extremes from %s", tableSize, path);
+    fclose(file);
+    return true;
+}
+
+Extremes *extremesLookup(int objectId, int instance) {
+    int index;
+    for (index = 0; index < tableSize; index++) {
+        if (table[index].objectId == objectId && table[index].instance == instance) {
+            return &table[index];
+        }
+    }
+
+    Extremes *extremes = addEntry(objectId, instance);
+    if (extremes == NULL) {
+        LOG(LOG_ERROR, "Extremes table full, /%d/%d not tracked", objectId, instance);
+    }
+    return extremes;
+}
+
+void extremesSeed(Extremes *extremes, bool hasMin, float min, bool hasMax, float max) {
+    if (hasMin && (!extremes->valid || min < extremes->min)) {
+        extremes->min = min;
+        extremes->minPending = false;
+    }
+    if (hasMax && (!extremes->valid || max > extremes->max)) {
+        extremes->max = max;
+        extremes->maxPending = false;
+    }
+    extremes->valid = extremes->valid || (hasMin && hasMax);
+    extremes->seeded = true;
+    dirty = dirty || hasMin || hasMax;
+}
+
+void extremesUpdate(Extremes *extremes, float min, float max) {
+    if (!extremes->valid || min < extremes->min) {
+        extremes->min = min;
+        extremes->minPending = true;
+        dirty = true;
+    }
+    if (!extremes->valid || max > extremes->max) {
+        extremes->max = max;
+        extremes->maxPending = true;
+        dirty = true;
+    }
+    extremes->valid = true;
+}
+
+bool extremesExtended(int objectId, int instance, float min, float max) {
+    const Extremes *extremes = extremesLookup(objectId, instance);
+    return extremes == NULL || !extremes->valid || min < extremes->min || max > extremes->max;
+}
+
+void extremesCheckpoint(bool force) {
+    int index;
+    char tmpPath[256];
+    time_t now = time(NULL);
+
+    if (checkpointPath == NULL || !dirty) {
+        return;
+    }
+    if (!force && now - lastCheckpoint < EXTREMES_CHECKPOINT_INTERVAL) {
+        return;
+    }
+
+    // write aside and rename, so a power cut never leaves a truncated checkpoint behind
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", checkpointPath);
+    FILE *file = fopen(tmpPath, "w");
+    if (file == NULL) {
+        LOG(LOG_ERROR, "Can't open %s for writing", tmpPath);
+        return;
+    }
+
+    for (index = 0; index < tableSize; index++) {
+        if (table[index].valid) {
+            fprintf(file, "%d %d %f %f\n", table[index].objectId, table[index].instance,
+                    table[index].min, table[index].max);
+        }
+    }
+
+    fflush(file);
+    fsync(fileno(file));
+    fclose(file);
+    if (rename(tmpPath, checkpointPath) != 0) {
+        LOG(LOG_ERROR, "Can't store extremes checkpoint in %s", checkpointPath);
+        return;
+    }
+
+    LOG(LOG_DEBUG, "Extremes checkpoint written to %s", checkpointPath);
+    dirty = false;
+    lastCheckpoint = now;
+}
@@ -0,0 +1,66 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file extremes.h
+ * @brief In-process table of min/max measured values (5601/5602) with a checkpoint file on flash.
+ */
+
+#ifndef EXTREMES_H
+#define EXTREMES_H
+
+#include <stdbool.h>
+
+/** Maximum number of object instances tracked. */
+#define EXTREMES_MAX_ENTRIES            (256)
+/** Minimal delay in seconds between two checkpoint writes, keeps flash wear low. */
+#define EXTREMES_CHECKPOINT_INTERVAL    (600)
+#define DEFAULT_EXTREMES_FILE           "/etc/weather_station_extremes"
+
+typedef struct {
+    int objectId;
+    int instance;
+    float min;
+    float max;
+    bool valid;         /**< min/max hold at least one value */
+    bool seeded;        /**< values stored by the client daemon were already merged in */
+    bool minPending;    /**< min changed and was not written to the daemon yet */
+    bool maxPending;    /**< max changed and was not written to the daemon yet */
+} Extremes;
+
+/** Read checkpoint file, entries found there are treated as seeded. Missing file is not an error. */
+bool extremesLoad(const char *path);
+
+/** Get entry of /objectId/instance, a new unseeded one is added if not tracked yet. */
+Extremes *extremesLookup(int objectId, int instance);
+
+/** Merge extremes read back from the client daemon, done once per entry. */
+void extremesSeed(Extremes *extremes, bool hasMin, float min, bool hasMax, float max);
+
+/** Account extremes of new measurement, marks min and/or max pending when they change. */
+void extremesUpdate(Extremes *extremes, float min, float max);
+
+/** Check whether measurement with given extremes would change min or max of /objectId/instance. */
+bool extremesExtended(int objectId, int instance, float min, float max);
+
+/** Write table to the checkpoint file if it changed and, unless forced, the checkpoint interval elapsed. */
+void extremesCheckpoint(bool force);
+
+#endif  /* EXTREMES_H */
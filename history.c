@@ -0,0 +1,586 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "history.h"
+#include "log.h"
+
+#define HISTORY_MAGIC       (0x49485357)    // "WSHI"
+#define HISTORY_VERSION     (1)
+/** Longest encoding of a sample: 36 bits of timestamp and 77 bits of value. */
+#define SAMPLE_MAX_BITS     (113)
+#define NO_WINDOW           (0xff)
+
+typedef struct {
+    int32_t objectId;
+    int32_t instance;
+    uint32_t blockCount;
+} SeriesRecord;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t blockSize;
+    uint32_t seriesCount;
+} FileHeader;
+
+/** Everything but the data is stored in the checkpoint as it is, encoder state included. */
+typedef struct {
+    uint32_t count;
+    uint32_t bits;
+    int64_t firstMs;
+    int64_t lastMs;
+    int64_t lastDelta;
+    uint64_t lastValue;     /**< bits of the last double */
+    uint8_t leading;        /**< XOR window of the last value which opened one, NO_WINDOW before it */
+    uint8_t trailing;
+} BlockHeader;
+
+typedef struct {
+    BlockHeader header;
+    int series;             /**< owning series, -1 when free */
+    int next;               /**< newer block of the series or next free block, -1 at the end */
+    uint8_t data[HISTORY_BLOCK_SIZE];
+} Block;
+
+typedef struct {
+    int objectId;
+    int instance;
+    int oldest;
+    int newest;
+} Series;
+
+typedef struct {
+    const Block *block;
+    uint32_t position;
+    uint32_t index;
+    int64_t timeMs;
+    int64_t delta;
+    uint64_t value;
+    int leading;
+    int trailing;
+} Reader;
+
+static Block *pool = NULL;
+static int capacity = 0;
+static int freeBlocks = -1;
+static Series series[HISTORY_MAX_SERIES];
+static int seriesCount = 0;
+static unsigned long evicted = 0;
+static const char *checkpointPath = NULL;
+static time_t lastCheckpoint = 0;
+static bool dirty = false;
+
+static uint64_t doubleBits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bitsDouble(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void writeBits(Block *block, uint64_t value, int count) {
+    while (count > 0) {
+        uint32_t bit = block->header.bits;
+        int free = 8 - (int)(bit % 8);
+        int take = count < free ? count : free;
+        uint8_t chunk = (uint8_t)((value >> (count - take)) & ((1u << take) - 1));
+
+        if (bit % 8 == 0) {
+            block->data[bit / 8] = 0;
+        }
+        block->data[bit / 8] |= (uint8_t)(chunk << (free - take));
+        block->header.bits += take;
+        count -= take;
+    }
+}
+
+static uint64_t readBits(Reader *reader, int count) {
+    uint64_t value = 0;
+
+    while (count > 0) {
+        uint32_t bit = reader->position;
+        int available = 8 - (int)(bit % 8);
+        int take = count < available ? count : available;
+        uint8_t byte = reader->block->data[bit / 8];
+
+        value = (value << take) | ((byte >> (available - take)) & ((1u << take) - 1));
+        reader->position += take;
+        count -= take;
+    }
+    return value;
+}
+
+/** Delta of deltas in ms, zero for a steady cadence. Returns false when it doesn't fit 32 bits. */
+static bool writeTimestamp(Block *block, int64_t dod) {
+    if (dod == 0) {
+        writeBits(block, 0, 1);
+    } else if (dod >= -63 && dod <= 64) {
+        writeBits(block, 0x2, 2);
+        writeBits(block, (uint64_t)(dod + 63), 7);
+    } else if (dod >= -255 && dod <= 256) {
+        writeBits(block, 0x6, 3);
+        writeBits(block, (uint64_t)(dod + 255), 9);
+    } else if (dod >= -2047 && dod <= 2048) {
+        writeBits(block, 0xe, 4);
+        writeBits(block, (uint64_t)(dod + 2047), 12);
+    } else if (dod >= INT32_MIN && dod <= INT32_MAX) {
+        writeBits(block, 0xf, 4);
+        writeBits(block, (uint32_t)(int32_t)dod, 32);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static int64_t readTimestamp(Reader *reader) {
+    if (readBits(reader, 1) == 0) {
+        return 0;
+    }
+    if (readBits(reader, 1) == 0) {
+        return (int64_t)readBits(reader, 7) - 63;
+    }
+    if (readBits(reader, 1) == 0) {
+        return (int64_t)readBits(reader, 9) - 255;
+    }
+    if (readBits(reader, 1) == 0) {
+        return (int64_t)readBits(reader, 12) - 2047;
+    }
+    return (int32_t)(uint32_t)readBits(reader, 32);
+}
+
+/** Value XORed with the previous one, meaningful bits only, within the previous window when they fit in. */
+static void writeValue(Block *block, uint64_t value) {
+    BlockHeader *header = &block->header;
+    uint64_t xor = value ^ header->lastValue;
+
+    header->lastValue = value;
+    if (xor == 0) {
+        writeBits(block, 0, 1);
+        return;
+    }
+
+    int leading = __builtin_clzll(xor);
+    int trailing = __builtin_ctzll(xor);
+    if (leading > 31) {
+        leading = 31;
+    }
+
+    writeBits(block, 1, 1);
+    if (header->leading != NO_WINDOW && leading >= header->leading && trailing >= header->trailing) {
+        writeBits(block, 0, 1);
+        writeBits(block, xor >> header->trailing, 64 - header->leading - header->trailing);
+        return;
+    }
+
+    int meaningful = 64 - leading - trailing;
+    writeBits(block, 1, 1);
+    writeBits(block, (uint64_t)leading, 5);
+    writeBits(block, (uint64_t)(meaningful - 1), 6);
+    writeBits(block, xor >> trailing, meaningful);
+    header->leading = (uint8_t)leading;
+    header->trailing = (uint8_t)trailing;
+}
+
+static uint64_t readValue(Reader *reader) {
+    if (readBits(reader, 1) == 0) {
+        return reader->value;
+    }
+    if (readBits(reader, 1) != 0) {
+        reader->leading = (int)readBits(reader, 5);
+        reader->trailing = 64 - reader->leading - ((int)readBits(reader, 6) + 1);
+    }
+    reader->value ^= readBits(reader, 64 - reader->leading - reader->trailing) << reader->trailing;
+    return reader->value;
+}
+
+static bool readerNext(Reader *reader, int64_t *timeMs, double *value) {
+    const BlockHeader *header = &reader->block->header;
+
+    if (reader->index >= header->count) {
+        return false;
+    }
+    if (reader->index == 0) {
+        reader->timeMs = header->firstMs;
+        reader->value = readBits(reader, 64);
+    } else {
+        reader->delta += readTimestamp(reader);
+        reader->timeMs += reader->delta;
+        readValue(reader);
+    }
+    reader->index++;
+    *timeMs = reader->timeMs;
+    *value = bitsDouble(reader->value);
+    return true;
+}
+
+static void readerStart(Reader *reader, const Block *block) {
+    memset(reader, 0, sizeof(*reader));
+    reader->block = block;
+}
+
+static void releaseBlock(int index) {
+    pool[index].series = -1;
+    pool[index].next = freeBlocks;
+    freeBlocks = index;
+}
+
+/** Reuse the oldest block of any series which has a newer one to continue in. */
+static int evictOldest(void) {
+    int index;
+    int victim = -1;
+
+    for (index = 0; index < seriesCount; index++) {
+        const Series *candidate = &series[index];
+        if (candidate->oldest != candidate->newest && (victim < 0 ||
+                pool[candidate->oldest].header.firstMs < pool[series[victim].oldest].header.firstMs)) {
+            victim = index;
+        }
+    }
+    if (victim < 0) {
+        return -1;
+    }
+
+    int block = series[victim].oldest;
+    series[victim].oldest = pool[block].next;
+    evicted++;
+    return block;
+}
+
+static int allocateBlock(int owner) {
+    int index = freeBlocks;
+
+    if (index >= 0) {
+        freeBlocks = pool[index].next;
+    } else if ((index = evictOldest()) < 0) {
+        return -1;
+    }
+
+    memset(&pool[index].header, 0, sizeof(pool[index].header));
+    pool[index].header.leading = NO_WINDOW;
+    pool[index].series = owner;
+    pool[index].next = -1;
+    if (series[owner].newest >= 0) {
+        pool[series[owner].newest].next = index;
+    } else {
+        series[owner].oldest = index;
+    }
+    series[owner].newest = index;
+    return index;
+}
+
+static int findSeries(int objectId, int instance) {
+    int index;
+    for (index = 0; index < seriesCount; index++) {
+        if (series[index].objectId == objectId && series[index].instance == instance) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+static int addSeries(int objectId, int instance) {
+    if (seriesCount >= HISTORY_MAX_SERIES) {
+        return -1;
+    }
+    series[seriesCount].objectId = objectId;
+    series[seriesCount].instance = instance;
+    series[seriesCount].oldest = -1;
+    series[seriesCount].newest = -1;
+    return seriesCount++;
+}
+
+static bool loadCheckpoint(const char *path) {
+    FileHeader header;
+    SeriesRecord record;
+    uint32_t index;
+    uint32_t block;
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        LOG(LOG_INFO, "No history in %s, starting fresh", path);
+        return true;
+    }
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != HISTORY_MAGIC ||
+            header.version != HISTORY_VERSION || header.blockSize != HISTORY_BLOCK_SIZE) {
+        LOG(LOG_WARN, "History in %s not usable, starting fresh", path);
+        fclose(file);
+        return false;
+    }
+
+    for (index = 0; index < header.seriesCount; index++) {
+        if (fread(&record, sizeof(record), 1, file) != 1) {
+            break;
+        }
+        int owner = findSeries(record.objectId, record.instance);
+        if (owner < 0 && (owner = addSeries(record.objectId, record.instance)) < 0) {
+            break;
+        }
+        for (block = 0; block < record.blockCount; block++) {
+            BlockHeader blockHeader;
+            if (fread(&blockHeader, sizeof(blockHeader), 1, file) != 1 || blockHeader.bits > HISTORY_BLOCK_SIZE * 8) {
+                LOG(LOG_WARN, "History in %s truncated", path);
+                fclose(file);
+                return false;
+            }
+            int target = allocateBlock(owner);
+            if (target < 0 ||
+                    fread(pool[target].data, 1, (blockHeader.bits + 7) / 8, file) != (blockHeader.bits + 7) / 8) {
+                LOG(LOG_WARN, "History in %s truncated", path);
+                fclose(file);
+                return false;
+            }
+            pool[target].header = blockHeader;
+        }
+    }
+
+    LOG(LOG_INFO, "Loaded history of %d channels from %s", seriesCount, path);
+    fclose(file);
+    return true;
+}
+
+bool historyOpen(const char *path, unsigned int sizeKb) {
+    int index;
+
+    capacity = (int)((uint64_t)sizeKb * 1024 / sizeof(Block));
+    if (capacity < 1) {
+        LOG(LOG_ERROR, "History of %u KB can't hold a single block", sizeKb);
+        return false;
+    }
+    pool = (Block *)malloc(capacity * sizeof(Block));
+    if (pool == NULL) {
+        LOG(LOG_ERROR, "Can't allocate history of %u KB", sizeKb);
+        capacity = 0;
+        return false;
+    }
+    for (index = capacity - 1; index >= 0; index--) {
+        releaseBlock(index);
+    }
+
+    lastCheckpoint = time(NULL);
+    if (path == NULL || path[0] == '\0') {
+        return true;
+    }
+    checkpointPath = path;
+    return loadCheckpoint(path);
+}
+
+bool historyAppend(int objectId, int instance, int64_t timeMs, double value) {
+    if (pool == NULL) {
+        return false;
+    }
+
+    int owner = findSeries(objectId, instance);
+    if (owner < 0 && (owner = addSeries(objectId, instance)) < 0) {
+        LOG(LOG_ERROR, "Too many channels, history of /%d/%d not kept", objectId, instance);
+        return false;
+    }
+
+    Block *block = series[owner].newest >= 0 ? &pool[series[owner].newest] : NULL;
+    if (block != NULL && block->header.count > 0 && timeMs < block->header.lastMs) {
+        LOG(LOG_DEBUG, "Sample of /%d/%d older than its history dropped", objectId, instance);
+        return false;
+    }
+
+    if (block != NULL && block->header.count > 0) {
+        int64_t delta = timeMs - block->header.lastMs;
+        int64_t dod = delta - block->header.lastDelta;
+        uint32_t bits = block->header.bits;
+
+        if (bits + SAMPLE_MAX_BITS <= HISTORY_BLOCK_SIZE * 8 && writeTimestamp(block, dod)) {
+            writeValue(block, doubleBits(value));
+            block->header.lastDelta = delta;
+            block->header.lastMs = timeMs;
+            block->header.count++;
+            dirty = true;
+            return true;
+        }
+        block->header.bits = bits;
+    }
+
+    int index = allocateBlock(owner);
+    if (index < 0) {
+        LOG(LOG_WARN, "History too small to keep /%d/%d", objectId, instance);
+        return false;
+    }
+    block = &pool[index];
+    block->header.firstMs = timeMs;
+    block->header.lastMs = timeMs;
+    block->header.lastValue = doubleBits(value);
+    block->header.count = 1;
+    writeBits(block, block->header.lastValue, 64);
+    dirty = true;
+    return true;
+}
+
+int historyQuery(int objectId, int instance, int64_t fromMs, int64_t toMs, int64_t stepMs, HistoryPoint *points,
+                 int maxPoints) {
+    int owner = findSeries(objectId, instance);
+    int count = 0;
+    bool full = false;
+    int index;
+    Reader reader;
+    int64_t timeMs;
+    double value;
+
+    if (owner < 0 || maxPoints <= 0) {
+        return 0;
+    }
+
+    for (index = series[owner].oldest; index >= 0 && !full; index = pool[index].next) {
+        const Block *block = &pool[index];
+        if (block->header.lastMs < fromMs || block->header.firstMs >= toMs) {
+            continue;
+        }
+
+        readerStart(&reader, block);
+        while (!full && readerNext(&reader, &timeMs, &value)) {
+            if (timeMs < fromMs || timeMs >= toMs) {
+                continue;
+            }
+
+            int64_t startMs = stepMs > 0 ? fromMs + (timeMs - fromMs) / stepMs * stepMs : timeMs;
+            HistoryPoint *point = count > 0 && stepMs > 0 ? &points[count - 1] : NULL;
+            if (point == NULL || point->startMs != startMs) {
+                if (count == maxPoints) {
+                    full = true;
+                    break;
+                }
+                point = &points[count++];
+                point->startMs = startMs;
+                point->min = value;
+                point->max = value;
+                point->mean = 0;
+                point->count = 0;
+            }
+            // mean holds the sum until all samples are in
+            point->min = value < point->min ? value : point->min;
+            point->max = value > point->max ? value : point->max;
+            point->mean += value;
+            point->count++;
+        }
+    }
+
+    for (index = 0; index < count; index++) {
+        points[index].mean /= points[index].count;
+    }
+    return count;
+}
+
+bool historyGetSeries(int index, HistorySeries *out) {
+    int block;
+
+    if (index < 0 || index >= seriesCount) {
+        return false;
+    }
+    memset(out, 0, sizeof(*out));
+    out->objectId = series[index].objectId;
+    out->instance = series[index].instance;
+    for (block = series[index].oldest; block >= 0; block = pool[block].next) {
+        if (out->blocks++ == 0) {
+            out->firstMs = pool[block].header.firstMs;
+        }
+        out->lastMs = pool[block].header.lastMs;
+        out->samples += pool[block].header.count;
+    }
+    return true;
+}
+
+void historyGetStats(HistoryStats *stats) {
+    int index;
+    int block;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->series = seriesCount;
+    stats->capacity = capacity;
+    stats->evicted = evicted;
+    for (index = 0; index < seriesCount; index++) {
+        for (block = series[index].oldest; block >= 0; block = pool[block].next) {
+            stats->blocks++;
+            stats->samples += pool[block].header.count;
+            stats->bytes += (pool[block].header.bits + 7) / 8;
+        }
+    }
+}
+
+void historyCheckpoint(bool force) {
+    char tmpPath[256];
+    int index;
+    int block;
+    time_t now = time(NULL);
+
+    if (checkpointPath == NULL || !dirty) {
+        return;
+    }
+    if (!force && now - lastCheckpoint < HISTORY_CHECKPOINT_INTERVAL) {
+        return;
+    }
+
+    // write aside and rename, so a power cut never leaves a truncated checkpoint behind
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", checkpointPath);
+    FILE *file = fopen(tmpPath, "w");
+    if (file == NULL) {
+        LOG(LOG_ERROR, "Can't open %s for writing", tmpPath);
+        return;
+    }
+
+    FileHeader header = {HISTORY_MAGIC, HISTORY_VERSION, 0, HISTORY_BLOCK_SIZE, (uint32_t)seriesCount};
+    fwrite(&header, sizeof(header), 1, file);
+    for (index = 0; index < seriesCount; index++) {
+        SeriesRecord record = {series[index].objectId, series[index].instance, 0};
+        for (block = series[index].oldest; block >= 0; block = pool[block].next) {
+            record.blockCount++;
+        }
+        fwrite(&record, sizeof(record), 1, file);
+        for (block = series[index].oldest; block >= 0; block = pool[block].next) {
+            fwrite(&pool[block].header, sizeof(pool[block].header), 1, file);
+            fwrite(pool[block].data, 1, (pool[block].header.bits + 7) / 8, file);
+        }
+    }
+
+    fflush(file);
+    fsync(fileno(file));
+    bool failed = ferror(file) != 0;
+    fclose(file);
+    if (failed || rename(tmpPath, checkpointPath) != 0) {
+        LOG(LOG_ERROR, "Can't write history to %s", checkpointPath);
+        return;
+    }
+    lastCheckpoint = now;
+    dirty = false;
+}
+
+void historyClose(void) {
+    historyCheckpoint(true);
+    free(pool);
+    pool = NULL;
+    capacity = 0;
+    freeBlocks = -1;
+    seriesCount = 0;
+}
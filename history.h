@@ -0,0 +1,99 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file history.h
+ * @brief Compressed history of every measured channel, kept on the gateway and queried with downsampling.
+ *
+ * Samples of a channel go into a chain of fixed size blocks. Within a block timestamps are stored as delta of
+ * deltas and values XORed with the previous one, both with variable length codes, so a steady cadence costs a few
+ * bits per timestamp and a slowly changing value a few more. All blocks come from one pool, when it is exhausted the
+ * oldest block of any channel is reused. The pool is written to a checkpoint file, which the history tool reads too.
+ * Not thread safe, used by the publishing thread only.
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! \{
+/** Bytes of compressed samples in a block, around 200 samples of a channel measured every few seconds. */
+#define HISTORY_BLOCK_SIZE          (1024)
+#define HISTORY_MAX_SERIES          (256)
+/** Default size of the block pool in KB. */
+#define DEFAULT_HISTORY_SIZE        (4096)
+#define DEFAULT_HISTORY_FILE        "/etc/weather_station_history"
+/** Minimal delay in seconds between two checkpoint writes, keeps flash wear low. */
+#define HISTORY_CHECKPOINT_INTERVAL (900)
+//! \}
+
+/** Samples within a step of a query, or a single sample when queried with zero step. */
+typedef struct {
+    int64_t startMs;        /**< start of the step, time of the sample with zero step */
+    double min;
+    double max;
+    double mean;
+    unsigned int count;
+} HistoryPoint;
+
+typedef struct {
+    int objectId;
+    int instance;
+    int64_t firstMs;        /**< oldest sample still kept */
+    int64_t lastMs;
+    unsigned long samples;  /**< samples still kept */
+    int blocks;
+} HistorySeries;
+
+typedef struct {
+    int series;
+    int blocks;             /**< blocks in use */
+    int capacity;           /**< blocks in the pool */
+    unsigned long samples;
+    unsigned long bytes;    /**< compressed samples stored */
+    unsigned long evicted;  /**< blocks reused while still holding samples */
+} HistoryStats;
+
+/** Allocate pool of sizeKb, blocks of a checkpoint found at path are loaded into it. Empty path keeps no file. */
+bool historyOpen(const char *path, unsigned int sizeKb);
+
+/** Account sample of /objectId/instance taken at timeMs (epoch ms). Samples older than the last one are dropped. */
+bool historyAppend(int objectId, int instance, int64_t timeMs, double value);
+
+/**
+ * Fill points with samples of /objectId/instance taken within [fromMs, toMs), aggregated by stepMs, every sample
+ * on its own with zero step. Steps without samples are left out. Returns number of points filled, at most maxPoints.
+ */
+int historyQuery(int objectId, int instance, int64_t fromMs, int64_t toMs, int64_t stepMs, HistoryPoint *points,
+                 int maxPoints);
+
+/** Describe series at the given index, false past the last one. */
+bool historyGetSeries(int index, HistorySeries *series);
+
+void historyGetStats(HistoryStats *stats);
+
+/** Write pool to the checkpoint file if it changed and, unless forced, the checkpoint interval elapsed. */
+void historyCheckpoint(bool force);
+
+void historyClose(void);
+
+#endif  /* HISTORY_H */
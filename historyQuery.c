@@ -0,0 +1,165 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file historyQuery.c
+ * @brief Prints history kept by the weather station from its checkpoint file, without asking the device server.
+ */
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "history.h"
+#include "scheduler.h"
+#include "log.h"
+
+int g_LogLevel = LOG_WARN;
+FILE *g_DebugStream;
+
+static void printUsage(const char *program)
+{
+    printf("Usage: %s [options]\n\n"
+        "Lists channels kept in the history, or prints samples of one of them as CSV lines\n"
+        "time (epoch ms), min, max, mean, count.\n\n"
+        " -f, --history  : History file of the weather station (default: " DEFAULT_HISTORY_FILE ")\n"
+        " -o, --object   : IPSO object id of the channel, e.g. 3303\n"
+        " -n, --instance : Instance of the channel (default: 0)\n"
+        " -l, --last     : Only samples of this last period, in seconds or with 'ms' suffix (default: all)\n"
+        " -s, --step     : Aggregate samples over steps of this length (default: every sample)\n"
+        " -h, --help     : prints this help\n",
+        program);
+}
+
+static void listSeries(void) {
+    HistorySeries series;
+    int index;
+
+    printf("object,instance,samples,blocks,first,last\n");
+    for (index = 0; historyGetSeries(index, &series); index++) {
+        printf("%d,%d,%lu,%d,%lld,%lld\n", series.objectId, series.instance, series.samples, series.blocks,
+               (long long)series.firstMs, (long long)series.lastMs);
+    }
+}
+
+static bool printSeries(int objectId, int instance, long lastMs, long stepMs) {
+    HistorySeries series;
+    struct timespec now;
+    int index;
+    int count;
+
+    for (index = 0; historyGetSeries(index, &series); index++) {
+        if (series.objectId == objectId && series.instance == instance) {
+            break;
+        }
+    }
+    if (series.objectId != objectId || series.instance != instance || series.samples == 0) {
+        fprintf(stderr, "No history of /%d/%d\n", objectId, instance);
+        return false;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    int64_t toMs = series.lastMs + 1;
+    int64_t fromMs = lastMs > 0 ? (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000 - lastMs : 0;
+    HistoryPoint *points = (HistoryPoint *)malloc(series.samples * sizeof(HistoryPoint));
+    if (points == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return false;
+    }
+
+    count = historyQuery(objectId, instance, fromMs, toMs, stepMs, points, (int)series.samples);
+    printf("time,min,max,mean,count\n");
+    for (index = 0; index < count; index++) {
+        printf("%lld,%g,%g,%g,%u\n", (long long)points[index].startMs, points[index].min, points[index].max,
+               points[index].mean, points[index].count);
+    }
+    free(points);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const char *path = DEFAULT_HISTORY_FILE;
+    int objectId = -1;
+    int instance = 0;
+    long lastMs = 0;
+    long stepMs = 0;
+    struct stat info;
+    int c;
+
+    g_DebugStream = stderr;
+    while (true) {
+        static struct option long_options[] = {
+        { "history", required_argument, 0, 'f'},
+        { "object", required_argument, 0, 'o'},
+        { "instance", required_argument, 0, 'n'},
+        { "last", required_argument, 0, 'l'},
+        { "step", required_argument, 0, 's'},
+        { "help", no_argument, 0, 'h'},
+        { 0, 0, 0, 0 } };
+
+        int option_index = 0;
+        c = getopt_long(argc, argv, "f:o:n:l:s:h", long_options, &option_index);
+        if (c == -1) break;
+
+        switch (c) {
+            case 'f':
+                path = optarg;
+                break;
+            case 'o':
+                objectId = atoi(optarg);
+                break;
+            case 'n':
+                instance = atoi(optarg);
+                break;
+            case 'l':
+                if ((lastMs = parsePeriodMs(optarg)) <= 0) {
+                    fprintf(stderr, "Bad period: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 's':
+                if ((stepMs = parsePeriodMs(optarg)) <= 0) {
+                    fprintf(stderr, "Bad step: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            default:
+                printUsage(argv[0]);
+                return c == 'h' ? 0 : 1;
+        }
+    }
+
+    if (stat(path, &info) != 0) {
+        fprintf(stderr, "No history in %s\n", path);
+        return 1;
+    }
+    // only the newest block of a channel is stored less than half full, so the pool takes every block of the file
+    unsigned long blocks = info.st_size / (HISTORY_BLOCK_SIZE / 2) + HISTORY_MAX_SERIES;
+    if (!historyOpen(path, (unsigned int)(blocks * (HISTORY_BLOCK_SIZE + 64) / 1024 + 1))) {
+        return 1;
+    }
+    if (objectId < 0) {
+        listSeries();
+        return 0;
+    }
+    return printSeries(objectId, instance, lastMs, stepMs) ? 0 : 1;
+}
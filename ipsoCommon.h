@@ -0,0 +1,44 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file ipsoCommon.h
+ * @brief Awa LwM2M constants shared by the weather station modules.
+ */
+
+#ifndef IPSO_COMMON_H
+#define IPSO_COMMON_H
+
+#define OPERATION_PERFORM_TIMEOUT 1000
+#define EXTENDED_OPERATION_PERFORM_TIMEOUT 5000
+
+//! \{
+#define IPSO_RESOURCE_SENSOR_VALUE  (5700)
+#define IPSO_RESOURCE_MIN_VALUE     (5601)
+#define IPSO_RESOURCE_MAX_VALUE     (5602)
+#define IPSO_RESOURCE_UNITS         (5701)
+//! \}
+
+/** Size of buffers holding "/object/instance/resource" paths. */
+#define IPSO_PATH_SIZE  (40)
+/** Size of buffers holding LwM2M client endpoint names. */
+#define IPSO_CLIENT_ID_SIZE (64)
+
+#endif  /* IPSO_COMMON_H */
@@ -0,0 +1,175 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <awa/common.h>
+#include <awa/client.h>
+#include "ipsoCommon.h"
+#include "ipsoObjects.h"
+#include "measurementBatch.h"
+#include "awaSession.h"
+#include "stats.h"
+#include "log.h"
+
+//! \{
+#define DEVICE_SERIAL_NUMBER_SIZE       (32)
+#define IPSO_RESOURCE_APPLICATION_TYPE  (5750)
+//! \}
+
+typedef struct {
+    int objectId;
+    const char *name;
+    bool applicationType;   /**< has Application Type resource */
+} SensorObject;
+
+static const SensorObject sensorObjects[] = {
+    { 3303, "Temperature", false },
+    { 3304, "Humidity", false },
+    { 3315, "Barometer", false },
+    { 3325, "Concentration", true },
+    { 3328, "Power", true },
+    { 3330, "Distance", true }
+};
+
+static AwaObjectDefinition *newSensorDefinition(const SensorObject *object) {
+    AwaObjectDefinition *definition = AwaObjectDefinition_New(object->objectId, object->name, 0, AWA_MAX_ID);
+    if (definition == NULL) {
+        return NULL;
+    }
+
+    AwaObjectDefinition_AddResourceDefinitionAsFloat(definition, IPSO_RESOURCE_SENSOR_VALUE, "Sensor Value", true,
+                                                     AwaResourceOperations_ReadOnly, 0);
+    AwaObjectDefinition_AddResourceDefinitionAsString(definition, IPSO_RESOURCE_UNITS, "Units", false,
+                                                      AwaResourceOperations_ReadOnly, "");
+    AwaObjectDefinition_AddResourceDefinitionAsFloat(definition, IPSO_RESOURCE_MIN_VALUE, "Min Measured Value", false,
+                                                     AwaResourceOperations_ReadOnly, 0);
+    AwaObjectDefinition_AddResourceDefinitionAsFloat(definition, IPSO_RESOURCE_MAX_VALUE, "Max Measured Value", false,
+                                                     AwaResourceOperations_ReadOnly, 0);
+    if (object->applicationType) {
+        AwaObjectDefinition_AddResourceDefinitionAsString(definition, IPSO_RESOURCE_APPLICATION_TYPE,
+                                                          "Application Type", false, AwaResourceOperations_ReadOnly, "");
+    }
+    return definition;
+}
+
+static AwaObjectDefinition *newDeviceDefinition(void) {
+    AwaObjectDefinition *definition = AwaObjectDefinition_New(DEVICE_OBJECT_ID, "Device", 1, 1);
+    if (definition == NULL) {
+        return NULL;
+    }
+
+    AwaObjectDefinition_AddResourceDefinitionAsString(definition, DEVICE_RESOURCE_SERIAL_NUMBER, "Serial Number", true,
+                                                      AwaResourceOperations_ReadOnly, "");
+    return definition;
+}
+
+/** Queue definition unless the daemon knows the object already, definition is freed. */
+static int addDefinition(AwaClientDefineOperation *operation, const AwaClientSession *session, int objectId,
+                         AwaObjectDefinition *definition) {
+    int added = 0;
+
+    if (definition == NULL) {
+        LOG(LOG_ERROR, "Can't build definition of object %d", objectId);
+    } else if (!AwaClientSession_IsObjectDefined(session, objectId)) {
+        added = AwaClientDefineOperation_Add(operation, definition) == AwaError_Success ? 1 : 0;
+    }
+    AwaObjectDefinition_Free(&definition);
+    return added;
+}
+
+AwaError ipsoDefineObjects(AwaClientSession *session) {
+    size_t index;
+    int pending = 0;
+    AwaClientDefineOperation *operation = AwaClientDefineOperation_New(session);
+    if (operation == NULL) {
+        LOG(LOG_ERROR, "AwaClientDefineOperation_New() failed");
+        return AwaError_OutOfMemory;
+    }
+
+    for (index = 0; index < sizeof(sensorObjects) / sizeof(sensorObjects[0]); index++) {
+        pending += addDefinition(operation, session, sensorObjects[index].objectId,
+                                 newSensorDefinition(&sensorObjects[index]));
+    }
+    pending += addDefinition(operation, session, DEVICE_OBJECT_ID, newDeviceDefinition());
+    pending += addDefinition(operation, session, STATS_OBJECT_ID, statsNewDefinition());
+
+    AwaError result = AwaError_Success;
+    if (pending > 0) {
+        int64_t start = statsStart();
+        result = AwaClientDefineOperation_Perform(operation, awaSessionTimeoutMs());
+        awaSessionMeasure(start, result);
+        // another process may have defined some of them in the meantime
+        if (result == AwaError_AlreadyDefined) {
+            result = AwaError_Success;
+        }
+        statsRecord(StatsStage_Define, start, statsAwaOutcome(result));
+        LOG(LOG_INFO, "Defined %d objects: %d", pending, result);
+    }
+    AwaClientDefineOperation_Free(&operation);
+    return result;
+}
+
+/** MAC address of the board, the serial number the device object always had. */
+static bool readSerialNumber(char *serial, size_t size) {
+    FILE *file = fopen(DEVICE_SERIAL_NUMBER_FILE, "r");
+    if (file == NULL) {
+        return false;
+    }
+
+    bool found = fgets(serial, size, file) != NULL;
+    fclose(file);
+    serial[strcspn(serial, "\r\n")] = '\0';
+    return found && serial[0] != '\0';
+}
+
+AwaError ipsoCreateInstances(AwaClientSession *session, bool withStats) {
+    char path[IPSO_PATH_SIZE];
+    char serial[DEVICE_SERIAL_NUMBER_SIZE];
+    AwaClientSetOperation *operation = AwaClientSetOperation_New(session);
+    if (operation == NULL) {
+        LOG(LOG_ERROR, "AwaClientSetOperation_New() failed");
+        return AwaError_OutOfMemory;
+    }
+
+    sprintf(path, "/%d/0", DEVICE_OBJECT_ID);
+    AwaClientSetOperation_CreateObjectInstance(operation, path);
+    if (readSerialNumber(serial, sizeof(serial))) {
+        sprintf(path, "/%d/0/%d", DEVICE_OBJECT_ID, DEVICE_RESOURCE_SERIAL_NUMBER);
+        AwaClientSetOperation_AddValueAsCString(operation, path, serial);
+    }
+    int channels = batchAddInstances(operation);
+    if (withStats) {
+        statsAddInstances(operation);
+    }
+
+    int64_t start = statsStart();
+    AwaError result = AwaClientSetOperation_Perform(operation, awaSessionTimeoutMs());
+    awaSessionMeasure(start, result);
+    // instances left by an earlier run fail to be created, that's expected
+    if (result == AwaError_Success || result == AwaError_Response) {
+        batchInstancesCreated(AwaClientSetOperation_GetResponse(operation));
+        result = AwaError_Success;
+    }
+    statsRecord(StatsStage_Create, start, statsAwaOutcome(result));
+    LOG(LOG_INFO, "Created instances of %d channels: %d", channels, result);
+    AwaClientSetOperation_Free(&operation);
+    return result;
+}
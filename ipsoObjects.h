@@ -0,0 +1,51 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file ipsoObjects.h
+ * @brief Definitions of the IPSO objects published by the station and their instances, set up on the client daemon
+ * every time a session to it gets connected.
+ */
+
+#ifndef IPSO_OBJECTS_H
+#define IPSO_OBJECTS_H
+
+#include <stdbool.h>
+#include <awa/client.h>
+
+//! \{
+#define DEVICE_OBJECT_ID                (3)
+#define DEVICE_RESOURCE_SERIAL_NUMBER   (2)
+#define DEVICE_SERIAL_NUMBER_FILE       "/sys/class/net/eth0/address"
+//! \}
+
+/**
+ * Define the sensor, device and stats objects which the client daemon doesn't know yet, all with one define operation.
+ * Nothing is sent when all of them are defined already.
+ */
+AwaError ipsoDefineObjects(AwaClientSession *session);
+
+/**
+ * Create device instance with its serial number, instances of every registered channel and, if withStats, of the stats
+ * object with one set operation. Instances which exist already are kept as they are.
+ */
+AwaError ipsoCreateInstances(AwaClientSession *session, bool withStats);
+
+#endif  /* IPSO_OBJECTS_H */
@@ -0,0 +1,137 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file liveQuery.c
+ * @brief Prints latest values of the weather station from its shared memory segment.
+ */
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "liveValues.h"
+#include "scheduler.h"
+#include "log.h"
+
+int g_LogLevel = LOG_WARN;
+FILE *g_DebugStream;
+
+static void printUsage(const char *program)
+{
+    printf("Usage: %s [options]\n\n"
+        "Prints latest value of every channel, or of one of them, as CSV lines\n"
+        "object, instance, value, min, max, time (epoch ms), count.\n\n"
+        " -t, --live     : Shared memory segment of the weather station (default: " LIVE_VALUES_DEFAULT_NAME ")\n"
+        " -o, --object   : IPSO object id of the channel, e.g. 3303 (default: all channels)\n"
+        " -n, --instance : Instance of the channel (default: 0)\n"
+        " -w, --watch    : Print values again with this period, in seconds or with 'ms' suffix\n"
+        " -h, --help     : prints this help\n",
+        program);
+}
+
+static void printValue(const LiveValue *value) {
+    printf("%d,%d,%g,%g,%g,%lld,%u\n", value->objectId, value->instance, value->value, value->min, value->max,
+           (long long)value->timeMs, value->count);
+}
+
+static bool printValues(const LiveTable *table, int objectId, int instance) {
+    LiveValue value;
+    int index;
+
+    printf("object,instance,value,min,max,time,count\n");
+    if (objectId >= 0) {
+        if (!liveValuesFind(table, objectId, instance, &value)) {
+            fprintf(stderr, "No value of /%d/%d\n", objectId, instance);
+            return false;
+        }
+        printValue(&value);
+    } else {
+        for (index = 0; liveValuesRead(table, index, &value); index++) {
+            printValue(&value);
+        }
+    }
+    fflush(stdout);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const char *name = LIVE_VALUES_DEFAULT_NAME;
+    int objectId = -1;
+    int instance = 0;
+    long watchMs = 0;
+    bool success;
+    int c;
+
+    g_DebugStream = stderr;
+    while (true) {
+        static struct option long_options[] = {
+        { "live", required_argument, 0, 't'},
+        { "object", required_argument, 0, 'o'},
+        { "instance", required_argument, 0, 'n'},
+        { "watch", required_argument, 0, 'w'},
+        { "help", no_argument, 0, 'h'},
+        { 0, 0, 0, 0 } };
+
+        int option_index = 0;
+        c = getopt_long(argc, argv, "t:o:n:w:h", long_options, &option_index);
+        if (c == -1) break;
+
+        switch (c) {
+            case 't':
+                name = optarg;
+                break;
+            case 'o':
+                objectId = atoi(optarg);
+                break;
+            case 'n':
+                instance = atoi(optarg);
+                break;
+            case 'w':
+                if ((watchMs = parsePeriodMs(optarg)) <= 0) {
+                    fprintf(stderr, "Bad period: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            default:
+                printUsage(argv[0]);
+                return c == 'h' ? 0 : 1;
+        }
+    }
+
+    LiveTable *table = liveValuesAttach(name);
+    if (table == NULL) {
+        fprintf(stderr, "No values in %s, is the weather station running?\n", name);
+        return 1;
+    }
+    if (!liveValuesWriterRunning(table)) {
+        fprintf(stderr, "Weather station stopped, values are from its last run\n");
+    }
+
+    do {
+        success = printValues(table, objectId, instance);
+        if (watchMs > 0) {
+            schedulerSleepMs(watchMs);
+        }
+    } while (watchMs > 0);
+
+    liveValuesDetach(table);
+    return success ? 0 : 1;
+}
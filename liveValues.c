@@ -0,0 +1,200 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "liveValues.h"
+
+/** Reader gives up after this many torn copies, the writer must have died in the middle of an update. */
+#define READ_ATTEMPTS   (1000)
+
+static LiveTable *writerTable = NULL;
+
+LiveTable *liveValuesAttach(const char *name) {
+    struct stat info;
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(LiveTable)) {
+        close(fd);
+        return NULL;
+    }
+
+    LiveTable *table = (LiveTable *)mmap(NULL, sizeof(LiveTable), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (table == MAP_FAILED) {
+        return NULL;
+    }
+    if (table->magic != LIVE_VALUES_MAGIC || table->version != LIVE_VALUES_VERSION ||
+            table->slotSize != sizeof(LiveSlot) || table->maxSlots != LIVE_VALUES_MAX_SLOTS) {
+        munmap(table, sizeof(LiveTable));
+        return NULL;
+    }
+    return table;
+}
+
+void liveValuesDetach(LiveTable *table) {
+    if (table != NULL) {
+        munmap(table, sizeof(LiveTable));
+    }
+}
+
+bool liveValuesWriterRunning(const LiveTable *table) {
+    return atomic_load_explicit(&table->writerPid, memory_order_relaxed) != 0;
+}
+
+int liveValuesCount(const LiveTable *table) {
+    unsigned int count = atomic_load_explicit(&table->slotCount, memory_order_acquire);
+    return count < LIVE_VALUES_MAX_SLOTS ? (int)count : LIVE_VALUES_MAX_SLOTS;
+}
+
+bool liveValuesRead(const LiveTable *table, int index, LiveValue *value) {
+    int attempt;
+
+    if (index < 0 || index >= liveValuesCount(table)) {
+        return false;
+    }
+
+    const LiveSlot *slot = &table->slots[index];
+    for (attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+        unsigned int before = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+
+        value->objectId = slot->objectId;
+        value->instance = slot->instance;
+        value->count = slot->count;
+        value->timeMs = slot->timeMs;
+        value->value = slot->value;
+        value->min = slot->min;
+        value->max = slot->max;
+
+        // copy has to be complete before the sequence is checked again
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->sequence, memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool liveValuesFind(const LiveTable *table, int objectId, int instance, LiveValue *value) {
+    int count = liveValuesCount(table);
+    int index;
+
+    // identity of a slot never changes once it is counted
+    for (index = 0; index < count; index++) {
+        if (table->slots[index].objectId == objectId && table->slots[index].instance == instance) {
+            return liveValuesRead(table, index, value);
+        }
+    }
+    return false;
+}
+
+bool liveValuesOpen(const char *name) {
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (ftruncate(fd, sizeof(LiveTable)) != 0) {
+        close(fd);
+        return false;
+    }
+
+    LiveTable *table = (LiveTable *)mmap(NULL, sizeof(LiveTable), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (table == MAP_FAILED) {
+        return false;
+    }
+
+    // readers attaching meanwhile reject the table until the magic is back
+    table->magic = 0;
+    atomic_thread_fence(memory_order_release);
+    memset(table->slots, 0, sizeof(table->slots));
+    atomic_store_explicit(&table->slotCount, 0, memory_order_relaxed);
+    table->version = LIVE_VALUES_VERSION;
+    table->slotSize = sizeof(LiveSlot);
+    table->maxSlots = LIVE_VALUES_MAX_SLOTS;
+    atomic_store_explicit(&table->writerPid, getpid(), memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    table->magic = LIVE_VALUES_MAGIC;
+    writerTable = table;
+    return true;
+}
+
+bool liveValuesUpdate(int objectId, int instance, int64_t timeMs, double value, double min, double max) {
+    LiveTable *table = writerTable;
+    unsigned int count;
+    unsigned int index;
+
+    if (table == NULL) {
+        return false;
+    }
+
+    count = atomic_load_explicit(&table->slotCount, memory_order_relaxed);
+    for (index = 0; index < count; index++) {
+        if (table->slots[index].objectId == objectId && table->slots[index].instance == instance) {
+            break;
+        }
+    }
+
+    LiveSlot *slot = &table->slots[index];
+    if (index == count) {
+        if (count == LIVE_VALUES_MAX_SLOTS) {
+            return false;
+        }
+        // the new slot isn't counted yet, nobody reads it
+        slot->objectId = objectId;
+        slot->instance = instance;
+        slot->count = 1;
+        slot->timeMs = timeMs;
+        slot->value = value;
+        slot->min = min;
+        slot->max = max;
+        atomic_store_explicit(&table->slotCount, count + 1, memory_order_release);
+        return true;
+    }
+
+    unsigned int sequence = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->count++;
+    slot->timeMs = timeMs;
+    slot->value = value;
+    slot->min = min < slot->min ? min : slot->min;
+    slot->max = max > slot->max ? max : slot->max;
+    atomic_store_explicit(&slot->sequence, sequence + 2, memory_order_release);
+    return true;
+}
+
+void liveValuesClose(void) {
+    if (writerTable == NULL) {
+        return;
+    }
+    atomic_store_explicit(&writerTable->writerPid, 0, memory_order_relaxed);
+    munmap(writerTable, sizeof(LiveTable));
+    writerTable = NULL;
+}
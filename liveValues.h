@@ -0,0 +1,108 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file liveValues.h
+ * @brief Latest value of every channel in POSIX shared memory, for local processes which don't speak Awa.
+ *
+ * The station writes every sample into a fixed slot of its channel. Slots are guarded by a sequence counter which is
+ * odd while the slot is written (seqlock): readers copy the slot and retry when the counter changed meanwhile, so
+ * they never take a lock nor make a syscall, and never hold up the station. Slots are only added, the segment stays
+ * in place with the last values when the station stops.
+ *
+ * Readers link the weatherStationLive library, e.g.
+ *     LiveTable *table = liveValuesAttach(LIVE_VALUES_DEFAULT_NAME);
+ *     LiveValue value;
+ *     if (table != NULL && liveValuesFind(table, 3303, 0, &value)) ...
+ */
+
+#ifndef LIVE_VALUES_H
+#define LIVE_VALUES_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+//! \{
+#define LIVE_VALUES_DEFAULT_NAME    "/weather_station_values"
+#define LIVE_VALUES_MAX_SLOTS       (256)
+#define LIVE_VALUES_MAGIC           (0x56575357)    // "WSWV"
+#define LIVE_VALUES_VERSION         (1)
+//! \}
+
+/** One channel, a cache line each so that writing one slot never disturbs readers of another. */
+typedef struct {
+    _Alignas(64) atomic_uint sequence;  /**< odd while the slot is written */
+    int32_t objectId;
+    int32_t instance;
+    uint32_t count;                     /**< samples since the station started */
+    int64_t timeMs;                     /**< epoch ms of the sample */
+    double value;
+    double min;                         /**< since the station started */
+    double max;
+} LiveSlot;
+
+typedef struct {
+    uint32_t magic;                     /**< written last, once the segment is set up */
+    uint32_t version;
+    uint32_t slotSize;
+    uint32_t maxSlots;
+    atomic_int writerPid;               /**< zero once the station stopped */
+    atomic_uint slotCount;              /**< slots in use, a slot is complete before it is counted */
+    LiveSlot slots[LIVE_VALUES_MAX_SLOTS];
+} LiveTable;
+
+/** Consistent copy of a slot. */
+typedef struct {
+    int objectId;
+    int instance;
+    unsigned int count;
+    int64_t timeMs;
+    double value;
+    double min;
+    double max;
+} LiveValue;
+
+/** Reader side. Map segment of the given name read-only, NULL when the station never created it. */
+LiveTable *liveValuesAttach(const char *name);
+
+void liveValuesDetach(LiveTable *table);
+
+/** True while the station writing the segment runs. */
+bool liveValuesWriterRunning(const LiveTable *table);
+
+int liveValuesCount(const LiveTable *table);
+
+/** Copy slot at the given index, false past the last one or when the writer keeps it busy. */
+bool liveValuesRead(const LiveTable *table, int index, LiveValue *value);
+
+/** Copy slot of /objectId/instance, false when the station has no such channel. */
+bool liveValuesFind(const LiveTable *table, int objectId, int instance, LiveValue *value);
+
+/** Writer side. Create the segment, or take over the one left by the previous run and clear it. */
+bool liveValuesOpen(const char *name);
+
+/** Store sample of /objectId/instance, a slot is added on the first sample of a channel. */
+bool liveValuesUpdate(int objectId, int instance, int64_t timeMs, double value, double min, double max);
+
+/** Mark the station stopped and unmap the segment, which is left in place with the last values. */
+void liveValuesClose(void);
+
+#endif  /* LIVE_VALUES_H */
@@ -0,0 +1,213 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "log.h"
+
+typedef struct {
+	int level;
+	int line;
+	const char *file;
+	struct timespec time;
+	char message[LOG_MESSAGE_SIZE];
+} LogRecord;
+
+/* bounded multi-producer queue, sequence of a slot tells whether it is free or holds a record for the reader */
+typedef struct {
+	atomic_uint sequence;
+	LogRecord record;
+} LogSlot;
+
+static LogSlot slots[LOG_RING_SIZE];
+static atomic_uint enqueuePosition;
+static unsigned int dequeuePosition;
+static atomic_bool started = false;
+static atomic_bool stopping = false;
+static atomic_ulong dropped;
+static sem_t recordsReady;
+static pthread_t writerThread;
+
+/* stream may be left unset by the program, records go to stdout then */
+static FILE *outputStream(void) {
+	FILE *stream = g_DebugStream;
+	return stream != NULL ? stream : stdout;
+}
+
+static void writeRecord(FILE *stream, const LogRecord *record) {
+	static time_t cachedSecond = 0;
+	static char cachedTime[TIME_BUFFER_SIZE] = {0};
+
+	if (g_LogLevel == LOG_DEBUG) {
+		// formatting local time is costly, it changes only once per second anyway
+		if (record->time.tv_sec != cachedSecond) {
+			struct tm local;
+			cachedSecond = record->time.tv_sec;
+			strftime(cachedTime, TIME_BUFFER_SIZE, "%x %X", localtime_r(&cachedSecond, &local));
+		}
+		fprintf(stream, "\n[%s] %s:%d: %s\n", cachedTime, record->file, record->line, record->message);
+	} else {
+		fprintf(stream, "\n%s\n", record->message);
+	}
+}
+
+static bool popRecord(LogRecord *record) {
+	LogSlot *slot = &slots[dequeuePosition & (LOG_RING_SIZE - 1)];
+	unsigned int sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+
+	if (sequence != dequeuePosition + 1) {
+		return false;
+	}
+
+	*record = slot->record;
+	atomic_store_explicit(&slot->sequence, dequeuePosition + LOG_RING_SIZE, memory_order_release);
+	dequeuePosition++;
+	return true;
+}
+
+/** Write everything queued so far with a single flush. */
+static void drain(void) {
+	static unsigned long reportedDropped = 0;
+	LogRecord record;
+	FILE *stream = outputStream();
+	bool written = false;
+
+	while (popRecord(&record)) {
+		writeRecord(stream, &record);
+		written = true;
+	}
+
+	unsigned long droppedNow = atomic_load(&dropped);
+	if (droppedNow != reportedDropped) {
+		fprintf(stream, "\n%lu log messages dropped\n", droppedNow - reportedDropped);
+		reportedDropped = droppedNow;
+		written = true;
+	}
+	if (written) {
+		fflush(stream);
+	}
+}
+
+static void *writer(void *arg) {
+	(void)arg;
+	while (!atomic_load(&stopping)) {
+		sem_wait(&recordsReady);
+		drain();
+	}
+	return NULL;
+}
+
+void logStart(void) {
+	unsigned int index;
+
+	if (atomic_load(&started)) {
+		return;
+	}
+
+	for (index = 0; index < LOG_RING_SIZE; index++) {
+		atomic_init(&slots[index].sequence, index);
+	}
+	atomic_init(&enqueuePosition, 0);
+	dequeuePosition = 0;
+	sem_init(&recordsReady, 0, 0);
+	atomic_store(&stopping, false);
+
+	if (pthread_create(&writerThread, NULL, writer, NULL) == 0) {
+		atomic_store(&started, true);
+	}
+}
+
+void logStop(void) {
+	if (!atomic_load(&started)) {
+		return;
+	}
+
+	atomic_store(&stopping, true);
+	sem_post(&recordsReady);
+	pthread_join(writerThread, NULL);
+	atomic_store(&started, false);
+	drain();
+}
+
+void logWrite(int level, const char *file, int line, const char *format, ...) {
+	va_list args;
+	LogRecord direct;
+	LogRecord *record = &direct;
+	LogSlot *slot = NULL;
+	unsigned int position = 0;
+
+	if (atomic_load_explicit(&started, memory_order_acquire)) {
+		position = atomic_load_explicit(&enqueuePosition, memory_order_relaxed);
+		while (true) {
+			slot = &slots[position & (LOG_RING_SIZE - 1)];
+			int difference = (int)(atomic_load_explicit(&slot->sequence, memory_order_acquire) - position);
+
+			if (difference == 0) {
+				if (atomic_compare_exchange_weak_explicit(&enqueuePosition, &position, position + 1,
+						memory_order_relaxed, memory_order_relaxed)) {
+					break;
+				}
+			} else if (difference < 0) {
+				// never block the caller on a slow output
+				atomic_fetch_add(&dropped, 1);
+				return;
+			} else {
+				position = atomic_load_explicit(&enqueuePosition, memory_order_relaxed);
+			}
+		}
+		record = &slot->record;
+	}
+
+	record->level = level;
+	record->file = file;
+	record->line = line;
+	clock_gettime(CLOCK_REALTIME, &record->time);
+	va_start(args, format);
+	vsnprintf(record->message, LOG_MESSAGE_SIZE, format, args);
+	va_end(args);
+
+	if (slot == NULL) {
+		FILE *stream = outputStream();
+		writeRecord(stream, record);
+		fflush(stream);
+		return;
+	}
+
+	atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+	sem_post(&recordsReady);
+}
+
+unsigned long logDropped(void) {
+	return atomic_load(&dropped);
+}
@@ -28,9 +28,13 @@
  * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+
 /**
  * @file log.h
  * @brief Header file for logging.
+ *
+ * Messages are rendered into fixed size records pushed to a lock-free ring, a background thread adds time stamps and
+ * writes them out. Levels above LOG_COMPILE_LEVEL are compiled out.
  */
 
 #ifndef LOG_H
@@ -51,34 +55,39 @@
 #define TIME_BUFFER_SIZE  (32)
 //! \}
 
-/** Macro for printing logging message with current time, function and line no. */
-#define DEBUG_PRINT                                                                   \
-	do {                                                                              \
-		time_t currentTime = time(NULL);                                              \
-		char buffer[TIME_BUFFER_SIZE] = {0};                                          \
-		strftime(buffer, TIME_BUFFER_SIZE, "%x %X", localtime(&currentTime));         \
-		fprintf(g_DebugStream,"[%s] %s:%d: ", buffer, __FILENAME__, __LINE__);        \
-	} while (0)
+/** Most verbose level built in, set by the build system. */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_DEBUG
+#endif
+
+/** Number of records in the ring, has to be a power of two. */
+#define LOG_RING_SIZE     (256)
+/** Maximum length of a single message, longer ones are truncated. */
+#define LOG_MESSAGE_SIZE  (200)
 
 /** Macro for logging message at the specified level. */
 #define LOG(level, ...)                                                               \
 	do {                                                                              \
-		if (level <= g_LogLevel)                                               \
+		if ((level) <= LOG_COMPILE_LEVEL && (level) <= g_LogLevel)                    \
 		{                                                                             \
-			if (g_DebugStream == NULL)                                                \
-				g_DebugStream = stdout;                                               \
-			fprintf(g_DebugStream, "\n");                                             \
-			if (g_LogLevel == LOG_DEBUG)                                       \
-			{                                                                         \
-				DEBUG_PRINT;                                                          \
-			}                                                                         \
-			fprintf(g_DebugStream, __VA_ARGS__);                                      \
-			fprintf(g_DebugStream, "\n");                                             \
-			fflush(g_DebugStream);                                                    \
+			logWrite((level), __FILENAME__, __LINE__, __VA_ARGS__);                   \
 		}                                                                             \
 	} while (0)
 
-/** Output stream to dump logs. */
+/** Start background writer. Until then, and after logStop(), messages are written synchronously. */
+void logStart(void);
+
+/** Write out all pending messages and stop background writer. */
+void logStop(void);
+
+/** Queue message, use LOG macro instead. Message is dropped when the ring is full. */
+void logWrite(int level, const char *file, int line, const char *format, ...)
+	__attribute__((format(printf, 4, 5)));
+
+/** Number of messages dropped on full ring. */
+unsigned long logDropped(void);
+
+/** Output stream to dump logs, stdout while NULL. It has to stay open until logStop() returned. */
 extern FILE *g_DebugStream;
 extern int g_LogLevel;
 
@@ -0,0 +1,351 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <stdio.h>
+#include <awa/common.h>
+#include <awa/client.h>
+#include "ipsoCommon.h"
+#include "measurementBatch.h"
+#include "extremes.h"
+#include "awaSession.h"
+#include "stats.h"
+#include "log.h"
+
+typedef struct {
+    int objectId;
+    int instance;
+    const char *units;
+    float value;
+    bool pending;
+    Extremes *extremes;
+    char instancePath[IPSO_PATH_SIZE];
+    char valuePath[IPSO_PATH_SIZE];
+    char minPath[IPSO_PATH_SIZE];
+    char maxPath[IPSO_PATH_SIZE];
+    char unitsPath[IPSO_PATH_SIZE];
+} BatchChannel;
+
+static BatchChannel channels[BATCH_MAX_CHANNELS];
+static int channelCount = 0;
+static int pendingCount = 0;
+
+static BatchChannel *findChannel(int objectId, int instance) {
+    int index;
+    for (index = 0; index < channelCount; index++) {
+        if (channels[index].objectId == objectId && channels[index].instance == instance) {
+            return &channels[index];
+        }
+    }
+    return NULL;
+}
+
+static BatchChannel *addChannel(int objectId, int instance, const char *units) {
+    if (channelCount >= BATCH_MAX_CHANNELS) {
+        LOG(LOG_ERROR, "Too many instances, /%d/%d won't be published", objectId, instance);
+        return NULL;
+    }
+
+    BatchChannel *channel = &channels[channelCount++];
+    channel->objectId = objectId;
+    channel->instance = instance;
+    channel->units = units;
+    channel->pending = false;
+    channel->extremes = extremesLookup(objectId, instance);
+    sprintf(channel->instancePath, "/%d/%d", objectId, instance);
+    sprintf(channel->valuePath, "/%d/%d/%d", objectId, instance, IPSO_RESOURCE_SENSOR_VALUE);
+    sprintf(channel->minPath, "/%d/%d/%d", objectId, instance, IPSO_RESOURCE_MIN_VALUE);
+    sprintf(channel->maxPath, "/%d/%d/%d", objectId, instance, IPSO_RESOURCE_MAX_VALUE);
+    sprintf(channel->unitsPath, "/%d/%d/%d", objectId, instance, IPSO_RESOURCE_UNITS);
+    return channel;
+}
+
+bool batchRegisterChannel(int objectId, int instance, const char *units) {
+    BatchChannel *channel = findChannel(objectId, instance);
+    if (channel != NULL) {
+        channel->units = units;
+        return true;
+    }
+    return addChannel(objectId, instance, units) != NULL;
+}
+
+static const char *objectUnits(int objectId) {
+    int index;
+    for (index = 0; index < channelCount; index++) {
+        if (channels[index].objectId == objectId && channels[index].units != NULL) {
+            return channels[index].units;
+        }
+    }
+    return NULL;
+}
+
+bool batchAddMeasurement(int objectId, int instance, float value, float min, float max) {
+    // newer value of an instance still waiting for the flush replaces the older one
+    BatchChannel *channel = findChannel(objectId, instance);
+    if (channel == NULL && (channel = addChannel(objectId, instance, objectUnits(objectId))) == NULL) {
+        return false;
+    }
+
+    if (!channel->pending) {
+        channel->pending = true;
+        pendingCount++;
+    }
+    channel->value = value;
+    if (channel->extremes != NULL) {
+        extremesUpdate(channel->extremes, min, max);
+    }
+    return true;
+}
+
+bool batchPending(int objectId, int instance) {
+    const BatchChannel *channel = findChannel(objectId, instance);
+    return channel != NULL && channel->pending;
+}
+
+/**
+ * Merge extremes already stored by the client daemon into entries not seeded yet. All such entries are fetched with
+ * one get operation, afterwards extremes are never read back from the daemon.
+ */
+static void seedExtremes(AwaClientSession *session) {
+    int index;
+    int unseeded = 0;
+    AwaClientGetOperation *operation = AwaClientGetOperation_New(session);
+    if (operation == NULL) {
+        LOG(LOG_ERROR, "AwaClientGetOperation_New() failed");
+        return;
+    }
+
+    for (index = 0; index < channelCount; index++) {
+        const BatchChannel *channel = &channels[index];
+        if (channel->pending && channel->extremes != NULL && !channel->extremes->seeded) {
+            AwaClientGetOperation_AddPath(operation, channel->minPath);
+            AwaClientGetOperation_AddPath(operation, channel->maxPath);
+            unseeded++;
+        }
+    }
+
+    if (unseeded == 0) {
+        AwaClientGetOperation_Free(&operation);
+        return;
+    }
+
+    int64_t start = statsStart();
+    AwaError result = AwaClientGetOperation_Perform(operation, awaSessionTimeoutMs());
+    awaSessionMeasure(start, result);
+    statsRecord(StatsStage_ExtremesGet, start,
+                result == AwaError_Response ? StatsOutcome_Ok : statsAwaOutcome(result));
+    LOG(LOG_DEBUG, "Awa extremes get response: %d", result);
+    // any other error means the daemon didn't answer, try again on next flush
+    if (result == AwaError_Success || result == AwaError_Response) {
+        const AwaClientGetResponse *response = AwaClientGetOperation_GetResponse(operation);
+
+        for (index = 0; index < channelCount; index++) {
+            BatchChannel *channel = &channels[index];
+            const AwaFloat *min = NULL;
+            const AwaFloat *max = NULL;
+
+            if (!channel->pending || channel->extremes == NULL || channel->extremes->seeded) {
+                continue;
+            }
+            bool hasMin = response != NULL &&
+                AwaClientGetResponse_GetValueAsFloatPointer(response, channel->minPath, &min) == AwaError_Success;
+            bool hasMax = response != NULL &&
+                AwaClientGetResponse_GetValueAsFloatPointer(response, channel->maxPath, &max) == AwaError_Success;
+            extremesSeed(channel->extremes, hasMin, hasMin ? *min : 0, hasMax, hasMax ? *max : 0);
+        }
+    }
+
+    AwaClientGetOperation_Free(&operation);
+}
+
+static void addValues(AwaClientSetOperation *operation, const BatchChannel *channel) {
+    LOG(LOG_INFO, "Storing value %0.3f into %s", channel->value, channel->valuePath);
+    AwaClientSetOperation_AddValueAsFloat(operation, channel->valuePath, channel->value);
+    if (channel->extremes == NULL) {
+        return;
+    }
+    if (channel->extremes->minPending) {
+        AwaClientSetOperation_AddValueAsFloat(operation, channel->minPath, channel->extremes->min);
+    }
+    if (channel->extremes->maxPending) {
+        AwaClientSetOperation_AddValueAsFloat(operation, channel->maxPath, channel->extremes->max);
+    }
+}
+
+static bool pathFailed(const AwaClientSetResponse *response, const char *path) {
+    const AwaPathResult *pathResult = response != NULL ? AwaClientSetResponse_GetPathResult(response, path) : NULL;
+    return pathResult == NULL || AwaPathResult_GetError(pathResult) != AwaError_Success;
+}
+
+/**
+ * Second pass for measurements rejected by the daemon. Missing instances and optional resources are created within
+ * the same set operation which carries their values, a fresh instance gets its units too.
+ */
+static AwaError createAndSet(AwaClientSession *session, const AwaClientSetResponse *failedResponse) {
+    int index;
+    int pending = 0;
+    AwaClientSetOperation *operation = AwaClientSetOperation_New(session);
+    if (operation == NULL) {
+        LOG(LOG_ERROR, "AwaClientSetOperation_New() failed");
+        return AwaError_OutOfMemory;
+    }
+
+    for (index = 0; index < channelCount; index++) {
+        const BatchChannel *channel = &channels[index];
+        Extremes *extremes = channel->extremes;
+
+        if (!channel->pending) {
+            continue;
+        }
+        bool instanceMissing = pathFailed(failedResponse, channel->valuePath);
+        bool minMissing = extremes != NULL && extremes->minPending && pathFailed(failedResponse, channel->minPath);
+        bool maxMissing = extremes != NULL && extremes->maxPending && pathFailed(failedResponse, channel->maxPath);
+
+        if (!instanceMissing && !minMissing && !maxMissing) {
+            continue;
+        }
+
+        LOG(LOG_DEBUG, "Looks like instance of %s not exists, try to create one", channel->valuePath);
+        if (instanceMissing) {
+            AwaClientSetOperation_CreateObjectInstance(operation, channel->instancePath);
+            if (channel->units != NULL) {
+                AwaClientSetOperation_CreateOptionalResource(operation, channel->unitsPath);
+                AwaClientSetOperation_AddValueAsCString(operation, channel->unitsPath, channel->units);
+            }
+            // fresh instance has no extremes at all, write both of them
+            if (extremes != NULL) {
+                extremes->minPending = true;
+                extremes->maxPending = true;
+            }
+        }
+        if (minMissing || (instanceMissing && extremes != NULL)) {
+            AwaClientSetOperation_CreateOptionalResource(operation, channel->minPath);
+        }
+        if (maxMissing || (instanceMissing && extremes != NULL)) {
+            AwaClientSetOperation_CreateOptionalResource(operation, channel->maxPath);
+        }
+        addValues(operation, channel);
+        pending++;
+    }
+
+    int64_t start = statsStart();
+    AwaError result = pending > 0 ? AwaClientSetOperation_Perform(operation, awaSessionTimeoutMs())
+                                  : AwaError_Success;
+    if (pending > 0) {
+        awaSessionMeasure(start, result);
+    }
+    statsRecord(StatsStage_Create, start, statsAwaOutcome(result));
+    LOG(LOG_DEBUG, "Awa create response: %d", result);
+    AwaClientSetOperation_Free(&operation);
+    return result;
+}
+
+int batchAddInstances(AwaClientSetOperation *operation) {
+    int index;
+
+    for (index = 0; index < channelCount; index++) {
+        const BatchChannel *channel = &channels[index];
+
+        AwaClientSetOperation_CreateObjectInstance(operation, channel->instancePath);
+        if (channel->units != NULL) {
+            AwaClientSetOperation_CreateOptionalResource(operation, channel->unitsPath);
+            AwaClientSetOperation_AddValueAsCString(operation, channel->unitsPath, channel->units);
+        }
+        if (channel->extremes != NULL) {
+            AwaClientSetOperation_CreateOptionalResource(operation, channel->minPath);
+            AwaClientSetOperation_CreateOptionalResource(operation, channel->maxPath);
+        }
+    }
+    return channelCount;
+}
+
+void batchInstancesCreated(const AwaClientSetResponse *response) {
+    int index;
+
+    for (index = 0; index < channelCount; index++) {
+        Extremes *extremes = channels[index].extremes;
+
+        if (extremes == NULL) {
+            continue;
+        }
+        // creation of a resource which exists already fails, the daemon still has to be asked for its value unless
+        // the other one was missing, the instance is then taken as holding no extremes at all
+        bool minCreated = !pathFailed(response, channels[index].minPath);
+        bool maxCreated = !pathFailed(response, channels[index].maxPath);
+        if ((minCreated || maxCreated) && !extremes->seeded) {
+            extremesSeed(extremes, false, 0, false, 0);
+        }
+        extremes->minPending = extremes->minPending || (minCreated && extremes->valid);
+        extremes->maxPending = extremes->maxPending || (maxCreated && extremes->valid);
+    }
+}
+
+/** Empty the queue, extremes stay pending after a failure and get written again with the next flush. */
+static void clearPending(bool published) {
+    int index;
+
+    for (index = 0; index < channelCount; index++) {
+        BatchChannel *channel = &channels[index];
+        if (published && channel->pending && channel->extremes != NULL) {
+            channel->extremes->minPending = false;
+            channel->extremes->maxPending = false;
+        }
+        channel->pending = false;
+    }
+    pendingCount = 0;
+}
+
+AwaError batchFlush(AwaClientSession *session) {
+    int index;
+
+    if (pendingCount == 0) {
+        return AwaError_Success;
+    }
+
+    seedExtremes(session);
+
+    AwaClientSetOperation *operation = AwaClientSetOperation_New(session);
+    if (operation == NULL) {
+        LOG(LOG_ERROR, "AwaClientSetOperation_New() failed");
+        clearPending(false);
+        return AwaError_OutOfMemory;
+    }
+
+    for (index = 0; index < channelCount; index++) {
+        if (channels[index].pending) {
+            addValues(operation, &channels[index]);
+        }
+    }
+
+    int64_t start = statsStart();
+    AwaError result = AwaClientSetOperation_Perform(operation, awaSessionTimeoutMs());
+    awaSessionMeasure(start, result);
+    statsRecord(StatsStage_Publish, start, result == AwaError_Response ? StatsOutcome_Ok : statsAwaOutcome(result));
+    LOG(LOG_DEBUG, "Awa batch set response: %d (%d measurements)", result, pendingCount);
+    if (result == AwaError_Response || result == AwaError_PathInvalid || result == AwaError_PathNotFound) {
+        result = createAndSet(session, AwaClientSetOperation_GetResponse(operation));
+    } else if (result != AwaError_Success) {
+        LOG(LOG_ERROR, "Publishing %d measurements failed: %d", pendingCount, result);
+    }
+
+    AwaClientSetOperation_Free(&operation);
+    clearPending(result == AwaError_Success);
+    extremesCheckpoint(false);
+    return result;
+}
@@ -0,0 +1,70 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file measurementBatch.h
+ * @brief Collects the IPSO updates of one measurement cycle and publishes them with a single Awa set operation.
+ */
+
+#ifndef MEASUREMENT_BATCH_H
+#define MEASUREMENT_BATCH_H
+
+#include <stdbool.h>
+#include <awa/client.h>
+
+/** Maximum number of distinct instances published, their resource paths are formatted only once. */
+#define BATCH_MAX_CHANNELS  (256)
+
+/**
+ * Announce instance fed by a sensor, units are written to 5701 when the instance gets created. Instances not
+ * registered are tracked from their first measurement on, with units of a registered instance of the same object.
+ */
+bool batchRegisterChannel(int objectId, int instance, const char *units);
+
+/**
+ * Queue sensor value of /objectId/instance for the next flush, replaces value of the instance queued earlier. Min and
+ * max are extremes seen while measuring the value, for a single reading they are equal to it.
+ */
+bool batchAddMeasurement(int objectId, int instance, float value, float min, float max);
+
+/** True when a value of /objectId/instance is queued for the next flush, another one would replace it. */
+bool batchPending(int objectId, int instance);
+
+/**
+ * Publish all queued measurements with one set operation for 5700 and for 5601/5602 whose extremes changed. Extremes
+ * come from the in-process table, the daemon is asked for them only once per instance to seed it. Missing instances
+ * are created together with their values in one more set operation. The queue is always emptied.
+ * Returns result of the last set operation performed.
+ */
+AwaError batchFlush(AwaClientSession *session);
+
+/**
+ * Queue creation of every channel's instance with its units, min and max into operation, so that flushes don't have
+ * to create them. Returns number of channels queued.
+ */
+int batchAddInstances(AwaClientSetOperation *operation);
+
+/**
+ * Take results of the operation which batchAddInstances() went into. Min and max created by it hold nothing stored,
+ * they are not read back from the daemon and get written with the next flush.
+ */
+void batchInstancesCreated(const AwaClientSetResponse *response);
+
+#endif  /* MEASUREMENT_BATCH_H */
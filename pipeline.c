@@ -0,0 +1,216 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "pipeline.h"
+#include "scheduler.h"
+#include "stats.h"
+#include "log.h"
+
+struct Producer {
+    const char *name;
+    pthread_t thread;
+    SampleQueue queue;
+    AcquireFunc acquire;
+    void *context;
+    int periodMs;
+    PeriodicTimer timer;
+    atomic_bool finished;
+};
+
+static Producer producers[PIPELINE_MAX_PRODUCERS];
+static atomic_int producerCount = 0;
+static atomic_bool running = true;
+static sem_t samplesReady;
+static bool initialized = false;
+
+static void *producerThread(void *arg) {
+    Producer *producer = (Producer *)arg;
+
+    LOG(LOG_DEBUG, "Producer %s started", producer->name);
+    if (producer->periodMs > 0) {
+        timerStart(&producer->timer, producer->periodMs);
+    }
+    while (atomic_load(&running)) {
+        int64_t start = statsStart();
+        producer->acquire(producer, producer->context);
+        statsRecordCycle(StatsStage_Acquire, start, producer->periodMs);
+        if (producer->periodMs > 0 && timerWait(&producer->timer) > 0) {
+            LOG(LOG_WARN, "Producer %s skipped periods to catch up", producer->name);
+        }
+    }
+    atomic_store(&producer->finished, true);
+    return NULL;
+}
+
+Producer *pipelineStartProducer(const char *name, AcquireFunc acquire, void *context, int periodMs) {
+    int count = atomic_load(&producerCount);
+    if (count >= PIPELINE_MAX_PRODUCERS) {
+        LOG(LOG_ERROR, "Too many producers, %s not started", name);
+        return NULL;
+    }
+
+    if (!initialized) {
+        sem_init(&samplesReady, 0, 0);
+        initialized = true;
+    }
+
+    Producer *producer = &producers[count];
+    producer->name = name;
+    producer->acquire = acquire;
+    producer->context = context;
+    producer->periodMs = periodMs;
+    atomic_store(&producer->finished, false);
+    sampleQueueInit(&producer->queue);
+
+    // publish the producer before its thread may submit anything
+    atomic_store(&producerCount, count + 1);
+    if (pthread_create(&producer->thread, NULL, producerThread, producer) != 0) {
+        LOG(LOG_ERROR, "Can't start producer %s", name);
+        atomic_store(&producerCount, count);
+        return NULL;
+    }
+    return producer;
+}
+
+bool pipelineSubmit(Producer *producer, int objectId, int instance, double value) {
+    Sample sample;
+    sample.objectId = objectId;
+    sample.instance = instance;
+    sample.value = value;
+    sample.min = value;
+    sample.max = value;
+    sample.stddev = 0;
+    sample.count = 1;
+    return pipelineSubmitSample(producer, &sample);
+}
+
+bool pipelineSubmitSample(Producer *producer, Sample *sample) {
+    clock_gettime(CLOCK_REALTIME, &sample->timestamp);
+
+    if (!sampleQueuePush(&producer->queue, sample)) {
+        LOG(LOG_WARN, "Queue of %s full, sample of /%d/%d dropped", producer->name, sample->objectId,
+            sample->instance);
+        return false;
+    }
+    sem_post(&samplesReady);
+    return true;
+}
+
+bool pipelineWait(int timeoutMs) {
+    struct timespec deadline;
+
+    if (!initialized) {
+        usleep(timeoutMs * 1000);
+        return false;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += (long)(timeoutMs % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    while (sem_timedwait(&samplesReady, &deadline) != 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+
+    // let the other producers finish their cycle, then swallow wake ups of everything drained next
+    usleep(PIPELINE_GATHER_TIME_MS * 1000);
+    while (sem_trywait(&samplesReady) == 0);
+    return true;
+}
+
+int pipelineDrain(SampleHandler handler) {
+    int index;
+    int drained = 0;
+    int count = atomic_load(&producerCount);
+    Sample sample;
+
+    for (index = 0; index < count; index++) {
+        while (sampleQueuePop(&producers[index].queue, &sample)) {
+            handler(&sample);
+            drained++;
+        }
+    }
+    return drained;
+}
+
+unsigned long pipelineOverruns(void) {
+    int index;
+    unsigned long overruns = 0;
+    int count = atomic_load(&producerCount);
+
+    for (index = 0; index < count; index++) {
+        overruns += producers[index].timer.overruns;
+    }
+    return overruns;
+}
+
+unsigned long pipelineDroppedSamples(void) {
+    int index;
+    unsigned long dropped = 0;
+    int count = atomic_load(&producerCount);
+
+    for (index = 0; index < count; index++) {
+        dropped += producers[index].queue.dropped;
+    }
+    return dropped;
+}
+
+bool pipelineStop(void) {
+    int index;
+    int joined = 0;
+    int count = atomic_load(&producerCount);
+    int64_t deadline = schedulerNowMs() + PIPELINE_STOP_TIMEOUT_MS;
+    bool done[PIPELINE_MAX_PRODUCERS] = {false};
+
+    atomic_store(&running, false);
+    schedulerStop();
+
+    // a producer stuck on a hung device must not hold up the exit, only the finished ones are joined
+    while (joined < count && schedulerNowMs() < deadline) {
+        for (index = 0; index < count; index++) {
+            if (!done[index] && atomic_load(&producers[index].finished)) {
+                pthread_join(producers[index].thread, NULL);
+                done[index] = true;
+                joined++;
+            }
+        }
+        if (joined < count) {
+            usleep(PIPELINE_GATHER_TIME_MS * 1000);
+        }
+    }
+
+    for (index = 0; index < count; index++) {
+        if (!done[index]) {
+            LOG(LOG_ERROR, "Producer %s did not stop within %d ms", producers[index].name, PIPELINE_STOP_TIMEOUT_MS);
+        }
+    }
+    return joined == count;
+}
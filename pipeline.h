@@ -0,0 +1,77 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file pipeline.h
+ * @brief Concurrent sampling pipeline: one producer thread per mikroBUS slot or remote node feeding the publisher.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdbool.h>
+#include "sampleQueue.h"
+
+/** Maximum number of producers. */
+#define PIPELINE_MAX_PRODUCERS  (4)
+/** Time the publisher waits after first sample so samples of one cycle from all producers go out together, in ms. */
+#define PIPELINE_GATHER_TIME_MS (50)
+/** Time pipelineStop() waits for producers to finish their current cycle, in ms. */
+#define PIPELINE_STOP_TIMEOUT_MS (3000)
+
+typedef struct Producer Producer;
+
+/** Performs one acquisition cycle of a producer, samples are handed over with pipelineSubmit(). */
+typedef void (*AcquireFunc)(Producer *producer, void *context);
+
+/** Consumes a sample drained from the producers queues. */
+typedef void (*SampleHandler)(const Sample *sample);
+
+/**
+ * Start producer thread calling acquire every periodMs milliseconds. With zero period acquire is called back to back,
+ * it is then expected to block by itself.
+ */
+Producer *pipelineStartProducer(const char *name, AcquireFunc acquire, void *context, int periodMs);
+
+/** Timestamp single reading and pass it to the publisher, called from the producer thread. */
+bool pipelineSubmit(Producer *producer, int objectId, int instance, double value);
+
+/** Timestamp sample and pass it to the publisher, called from the producer thread. */
+bool pipelineSubmitSample(Producer *producer, Sample *sample);
+
+/** Block publisher until some producer submitted a sample or timeout (in ms) expired. */
+bool pipelineWait(int timeoutMs);
+
+/** Pass all queued samples to the handler, returns their number. Called from the publisher thread. */
+int pipelineDrain(SampleHandler handler);
+
+/** Total number of producer cycles which missed their deadline. */
+unsigned long pipelineOverruns(void);
+
+/** Total number of samples dropped on full queues. */
+unsigned long pipelineDroppedSamples(void);
+
+/**
+ * Stop producers after their current cycle, waking up those waiting for the next period, and join them. Returns false
+ * when some did not finish within PIPELINE_STOP_TIMEOUT_MS, those may still use their devices and queues.
+ */
+bool pipelineStop(void);
+
+#endif  /* PIPELINE_H */
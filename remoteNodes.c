@@ -0,0 +1,219 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <awa/common.h>
+#include "remoteNodes.h"
+#include "scheduler.h"
+#include "log.h"
+
+static RemoteNode nodes[REMOTE_NODES_MAX];
+static atomic_int nodeCount = 0;
+static bool pinned = false;
+static const char *nodesPath = NULL;
+static int64_t nextListMs = 0;
+static int readTimeoutMs = EXTENDED_OPERATION_PERFORM_TIMEOUT;
+
+static RemoteNode *findNode(const char *clientId) {
+    int index;
+    int count = atomic_load(&nodeCount);
+
+    for (index = 0; index < count; index++) {
+        if (strcmp(nodes[index].clientId, clientId) == 0) {
+            return &nodes[index];
+        }
+    }
+    return NULL;
+}
+
+/** Append node, it becomes visible to readers only when fully set up. */
+static RemoteNode *addNode(const char *clientId) {
+    int count = atomic_load(&nodeCount);
+
+    if (count >= REMOTE_NODES_MAX) {
+        LOG(LOG_ERROR, "Too many nodes, %s won't be relayed", clientId);
+        return NULL;
+    }
+
+    RemoteNode *node = &nodes[count];
+    memset(node, 0, sizeof(*node));
+    snprintf(node->clientId, sizeof(node->clientId), "%s", clientId);
+    node->index = count;
+    atomic_init(&node->registered, false);
+    atomic_init(&node->pending, false);
+    awaRttInit(&node->rtt, readTimeoutMs, AWA_RTT_MIN_MS, readTimeoutMs);
+    atomic_init(&node->reads, 0);
+    atomic_init(&node->failures, 0);
+    atomic_store(&nodeCount, count + 1);
+    return node;
+}
+
+static void storeNodes(void) {
+    char tmpPath[256];
+    int index;
+    int count = atomic_load(&nodeCount);
+
+    if (nodesPath == NULL || nodesPath[0] == '\0' || pinned) {
+        return;
+    }
+
+    // write aside and rename, a truncated file would move nodes to other instances
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", nodesPath);
+    FILE *file = fopen(tmpPath, "w");
+    if (file == NULL) {
+        LOG(LOG_ERROR, "Can't open %s for writing", tmpPath);
+        return;
+    }
+    for (index = 0; index < count; index++) {
+        fprintf(file, "%s\n", nodes[index].clientId);
+    }
+    fclose(file);
+    if (rename(tmpPath, nodesPath) != 0) {
+        LOG(LOG_ERROR, "Can't store nodes to %s", nodesPath);
+    }
+}
+
+void remoteNodesSetTimeout(int timeoutMs) {
+    readTimeoutMs = timeoutMs;
+}
+
+bool remoteNodesLoad(const char *path) {
+    char clientId[IPSO_CLIENT_ID_SIZE];
+
+    nodesPath = path;
+    if (path == NULL || path[0] == '\0' || pinned) {
+        return true;
+    }
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        LOG(LOG_INFO, "No nodes known from %s, numbering them as they register", path);
+        return true;
+    }
+    while (fscanf(file, "%63s", clientId) == 1) {
+        if (findNode(clientId) == NULL && addNode(clientId) == NULL) {
+            break;
+        }
+    }
+    fclose(file);
+    LOG(LOG_INFO, "Loaded %d nodes from %s", atomic_load(&nodeCount), path);
+    return true;
+}
+
+bool remoteNodesPin(const char *clientId) {
+    pinned = true;
+    return findNode(clientId) != NULL || addNode(clientId) != NULL;
+}
+
+static void setRegistered(const char *clientId, bool registered) {
+    RemoteNode *node = findNode(clientId);
+
+    if (node == NULL) {
+        if (!registered || pinned || (node = addNode(clientId)) == NULL) {
+            return;
+        }
+        storeNodes();
+    }
+    if (atomic_exchange(&node->registered, registered) != registered) {
+        LOG(LOG_INFO, "Node %s %s, instance block %d", clientId,
+            registered ? "registered" : "deregistered", node->index);
+    }
+}
+
+static void registerCallback(const AwaServerClientRegisterEvent *event, void *context) {
+    AwaClientIterator *iterator = AwaServerClientRegisterEvent_NewClientIterator(event);
+
+    (void)context;
+    while (AwaClientIterator_Next(iterator)) {
+        setRegistered(AwaClientIterator_GetClientID(iterator), true);
+    }
+    AwaClientIterator_Free(&iterator);
+}
+
+static void deregisterCallback(const AwaServerClientDeregisterEvent *event, void *context) {
+    AwaClientIterator *iterator = AwaServerClientDeregisterEvent_NewClientIterator(event);
+
+    (void)context;
+    while (AwaClientIterator_Next(iterator)) {
+        setRegistered(AwaClientIterator_GetClientID(iterator), false);
+    }
+    AwaClientIterator_Free(&iterator);
+}
+
+/** Mark exactly the listed clients registered. */
+static bool listClients(AwaServerSession *session) {
+    bool listed[REMOTE_NODES_MAX] = { false };
+    int index;
+
+    nextListMs = schedulerNowMs() + REMOTE_NODES_RETRY_MS;
+    AwaServerListClientsOperation *operation = AwaServerListClientsOperation_New(session);
+    if (operation == NULL) {
+        LOG(LOG_ERROR, "AwaServerListClientsOperation_New() failed");
+        return false;
+    }
+
+    AwaError result = AwaServerListClientsOperation_Perform(operation, EXTENDED_OPERATION_PERFORM_TIMEOUT);
+    if (result != AwaError_Success) {
+        LOG(LOG_ERROR, "Listing clients failed: %d", result);
+        AwaServerListClientsOperation_Free(&operation);
+        return false;
+    }
+
+    AwaClientIterator *iterator = AwaServerListClientsOperation_NewClientIterator(operation);
+    while (AwaClientIterator_Next(iterator)) {
+        const char *clientId = AwaClientIterator_GetClientID(iterator);
+        setRegistered(clientId, true);
+        RemoteNode *node = findNode(clientId);
+        if (node != NULL) {
+            listed[node->index] = true;
+        }
+    }
+    AwaClientIterator_Free(&iterator);
+    AwaServerListClientsOperation_Free(&operation);
+    nextListMs = schedulerNowMs() + REMOTE_NODES_RELIST_MS;
+
+    for (index = 0; index < atomic_load(&nodeCount); index++) {
+        if (!listed[index]) {
+            setRegistered(nodes[index].clientId, false);
+        }
+    }
+    return true;
+}
+
+bool remoteNodesWatch(AwaServerSession *session) {
+    AwaServerSession_SetClientRegisterEventCallback(session, &registerCallback, NULL);
+    AwaServerSession_SetClientDeregisterEventCallback(session, &deregisterCallback, NULL);
+    return listClients(session);
+}
+
+void remoteNodesMaintain(AwaServerSession *session) {
+    if (schedulerNowMs() >= nextListMs) {
+        listClients(session);
+    }
+}
+
+int remoteNodesCount(void) {
+    return atomic_load(&nodeCount);
+}
+
+RemoteNode *remoteNodesGet(int index) {
+    return index < atomic_load(&nodeCount) ? &nodes[index] : NULL;
+}
@@ -0,0 +1,83 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file remoteNodes.h
+ * @brief LwM2M clients relayed by the gateway: discovery through the server session and work sharing among readers.
+ *
+ * Nodes are kept in the order they were first seen, stored in a file, so every node keeps its client side instances
+ * across restarts. Nodes are only added, by the thread owning the discovery session; other threads may look them up
+ * at any time.
+ */
+
+#ifndef REMOTE_NODES_H
+#define REMOTE_NODES_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <awa/server.h>
+#include "awaRequest.h"
+#include "breaker.h"
+#include "ipsoCommon.h"
+
+//! \{
+#define REMOTE_NODES_MAX            (64)
+#define DEFAULT_NODES_FILE          "/etc/weather_station_nodes"
+/** Registered clients are listed again this often, in case some registration event got lost. */
+#define REMOTE_NODES_RELIST_MS      (300000)
+/** Listing is retried this often after it failed. */
+#define REMOTE_NODES_RETRY_MS       (10000)
+//! \}
+
+typedef struct {
+    char clientId[IPSO_CLIENT_ID_SIZE];
+    int index;                  /**< position in the nodes file, selects the client side instances */
+    atomic_bool registered;
+    atomic_bool pending;        /**< read of the node is in the request window */
+    AwaRtt rtt;                 /**< round trips of reads, owned by the read while it is pending */
+    atomic_ulong reads;
+    atomic_ulong failures;
+    Breaker breaker;            /**< quarantines a node failing its reads, taken by the read while it is pending */
+    bool observed;              /**< observations registered, owned by the discovery thread */
+    int64_t observeRetryMs;     /**< schedulerNowMs() of the next attempt to observe, owned by the discovery thread */
+} RemoteNode;
+
+/** Timeout of the first read of every node, and the limit its adaptive timeout never exceeds. */
+void remoteNodesSetTimeout(int timeoutMs);
+
+/** Load order of known nodes, empty path keeps it only in memory. Called before discovery starts. */
+bool remoteNodesLoad(const char *path);
+
+/** Relay only the given node, can be repeated. Without any node pinned all registered clients are relayed. */
+bool remoteNodesPin(const char *clientId);
+
+/** List the registered clients and follow their (de)registrations from now on. */
+bool remoteNodesWatch(AwaServerSession *session);
+
+/** List the registered clients again once REMOTE_NODES_RELIST_MS passed since the last time. */
+void remoteNodesMaintain(AwaServerSession *session);
+
+int remoteNodesCount(void);
+
+/** Node at the given position, NULL past the last one. */
+RemoteNode *remoteNodesGet(int index);
+
+#endif  /* REMOTE_NODES_H */
@@ -0,0 +1,260 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <awa/common.h>
+#include <awa/server.h>
+#include "ipsoCommon.h"
+#include "remoteObserve.h"
+#include "stats.h"
+#include "log.h"
+
+typedef struct {
+    int objectId;
+    int instance;
+    char path[IPSO_PATH_SIZE];
+} ObservedValue;
+
+typedef struct ObservedNode ObservedNode;
+
+typedef struct {
+    const ObservedValue *value;
+    ObservedNode *node;
+    AwaServerObservation *observation;
+} Observation;
+
+struct ObservedNode {
+    char clientId[IPSO_CLIENT_ID_SIZE];
+    void *context;
+    bool active;
+    time_t lastNotification;
+    Observation observations[REMOTE_OBSERVE_MAX_OBSERVATIONS];
+};
+
+static ObservedValue observed[REMOTE_OBSERVE_MAX_OBSERVATIONS];
+static int observedCount = 0;
+static ObservedNode nodes[REMOTE_OBSERVE_MAX_NODES];
+static ObserveAttributes observeAttributes = {-1, -1, -1};
+static RemoteValueHandler valueHandler = NULL;
+static int dispatched = 0;
+
+bool remoteObserveAdd(int objectId, int instance) {
+    if (observedCount >= REMOTE_OBSERVE_MAX_OBSERVATIONS) {
+        LOG(LOG_ERROR, "Too many observations, /%d/%d won't be observed", objectId, instance);
+        return false;
+    }
+
+    ObservedValue *value = &observed[observedCount++];
+    value->objectId = objectId;
+    value->instance = instance;
+    sprintf(value->path, "/%d/%d/%d", objectId, instance, IPSO_RESOURCE_SENSOR_VALUE);
+    return true;
+}
+
+void remoteObserveConfigure(const ObserveAttributes *attributes, RemoteValueHandler handler) {
+    observeAttributes = *attributes;
+    valueHandler = handler;
+}
+
+static void observeCallback(const AwaChangeSet *changeSet, void *context) {
+    Observation *observation = (Observation *)context;
+    const ObservedValue *value = observation->value;
+    const AwaFloat *awaValue = NULL;
+
+    if (AwaChangeSet_GetValueAsFloatPointer(changeSet, value->path, &awaValue) != AwaError_Success) {
+        return;
+    }
+
+    LOG(LOG_DEBUG, "Notification of %s from %s: %f", value->path, observation->node->clientId, *awaValue);
+    observation->node->lastNotification = time(NULL);
+    dispatched++;
+    valueHandler(observation->node->context, value->objectId, value->instance, *awaValue);
+}
+
+static void writeAttributes(AwaServerSession *session, const ObservedNode *node) {
+    int index;
+
+    if (observeAttributes.pmin < 0 && observeAttributes.pmax < 0 && observeAttributes.step < 0) {
+        return;
+    }
+
+    AwaServerWriteAttributesOperation *operation = AwaServerWriteAttributesOperation_New(session);
+    if (operation == NULL) {
+        LOG(LOG_ERROR, "AwaServerWriteAttributesOperation_New() failed");
+        return;
+    }
+
+    for (index = 0; index < observedCount; index++) {
+        const char *path = observed[index].path;
+        if (observeAttributes.pmin >= 0) {
+            AwaServerWriteAttributesOperation_AddAttributeAsInteger(operation, node->clientId, path, "pmin",
+                                                                    observeAttributes.pmin);
+        }
+        if (observeAttributes.pmax >= 0) {
+            AwaServerWriteAttributesOperation_AddAttributeAsInteger(operation, node->clientId, path, "pmax",
+                                                                    observeAttributes.pmax);
+        }
+        if (observeAttributes.step >= 0) {
+            AwaServerWriteAttributesOperation_AddAttributeAsFloat(operation, node->clientId, path, "stp",
+                                                                  observeAttributes.step);
+        }
+    }
+
+    int64_t start = statsStart();
+    AwaError result = AwaServerWriteAttributesOperation_Perform(operation, EXTENDED_OPERATION_PERFORM_TIMEOUT);
+    statsRecord(StatsStage_Observe, start, statsAwaOutcome(result));
+    LOG(LOG_DEBUG, "Awa write attributes response: %d", result);
+    if (result != AwaError_Success) {
+        LOG(LOG_WARN, "Writing notification attributes to %s failed: %d", node->clientId, result);
+    }
+    AwaServerWriteAttributesOperation_Free(&operation);
+}
+
+/** Register or cancel all observations of the node with a single observe operation. */
+static bool performObserve(AwaServerSession *session, ObservedNode *node, bool cancel) {
+    int index;
+    AwaServerObserveOperation *operation = AwaServerObserveOperation_New(session);
+    if (operation == NULL) {
+        LOG(LOG_ERROR, "AwaServerObserveOperation_New() failed");
+        return false;
+    }
+
+    for (index = 0; index < observedCount; index++) {
+        Observation *observation = &node->observations[index];
+        if (cancel) {
+            if (observation->observation != NULL) {
+                AwaServerObserveOperation_AddCancelObservation(operation, observation->observation);
+            }
+            continue;
+        }
+        if (observation->observation == NULL) {
+            observation->value = &observed[index];
+            observation->node = node;
+            observation->observation = AwaServerObservation_New(node->clientId, observed[index].path,
+                                                                 observeCallback, observation);
+        }
+        if (observation->observation != NULL) {
+            AwaServerObserveOperation_AddObservation(operation, observation->observation);
+        }
+    }
+
+    int64_t start = statsStart();
+    AwaError result = AwaServerObserveOperation_Perform(operation, EXTENDED_OPERATION_PERFORM_TIMEOUT);
+    statsRecord(StatsStage_Observe, start, statsAwaOutcome(result));
+    LOG(LOG_DEBUG, "Awa %s of %s response: %d", cancel ? "cancel observe" : "observe", node->clientId, result);
+    AwaServerObserveOperation_Free(&operation);
+
+    if (cancel) {
+        for (index = 0; index < observedCount; index++) {
+            if (node->observations[index].observation != NULL) {
+                AwaServerObservation_Free(&node->observations[index].observation);
+                node->observations[index].observation = NULL;
+            }
+        }
+    }
+    return result == AwaError_Success;
+}
+
+static ObservedNode *findNode(const char *clientId) {
+    int index;
+
+    for (index = 0; index < REMOTE_OBSERVE_MAX_NODES; index++) {
+        if (nodes[index].active && strcmp(nodes[index].clientId, clientId) == 0) {
+            return &nodes[index];
+        }
+    }
+    return NULL;
+}
+
+bool remoteObserveStart(AwaServerSession *session, const char *clientId, void *context) {
+    ObservedNode *node = findNode(clientId);
+    int index;
+
+    for (index = 0; node == NULL && index < REMOTE_OBSERVE_MAX_NODES; index++) {
+        if (!nodes[index].active) {
+            node = &nodes[index];
+        }
+    }
+    if (node == NULL) {
+        LOG(LOG_ERROR, "Too many observed nodes, %s won't be observed", clientId);
+        return false;
+    }
+
+    snprintf(node->clientId, sizeof(node->clientId), "%s", clientId);
+    node->context = context;
+    node->lastNotification = time(NULL);
+    writeAttributes(session, node);
+    if (!performObserve(session, node, false)) {
+        LOG(LOG_ERROR, "Observing %d values on %s failed", observedCount, clientId);
+        performObserve(session, node, true);
+        return false;
+    }
+
+    node->active = true;
+    LOG(LOG_INFO, "Observing %d values on %s", observedCount, clientId);
+    return true;
+}
+
+void remoteObserveCancel(AwaServerSession *session, const char *clientId) {
+    ObservedNode *node = findNode(clientId);
+
+    if (node != NULL) {
+        performObserve(session, node, true);
+        node->active = false;
+        LOG(LOG_INFO, "Stopped observing %s", clientId);
+    }
+}
+
+int remoteObserveProcess(AwaServerSession *session) {
+    int index;
+
+    dispatched = 0;
+    AwaServerSession_Process(session, REMOTE_OBSERVE_PROCESS_TIMEOUT);
+    AwaServerSession_DispatchCallbacks(session);
+
+    for (index = 0; observeAttributes.pmax > 0 && index < REMOTE_OBSERVE_MAX_NODES; index++) {
+        ObservedNode *node = &nodes[index];
+        if (!node->active ||
+                time(NULL) - node->lastNotification <= observeAttributes.pmax * REMOTE_OBSERVE_PMAX_TOLERANCE) {
+            continue;
+        }
+        LOG(LOG_WARN, "No notification from %s for %ld s, observing again", node->clientId,
+            (long)(time(NULL) - node->lastNotification));
+        performObserve(session, node, true);
+        writeAttributes(session, node);
+        performObserve(session, node, false);
+        node->lastNotification = time(NULL);
+    }
+
+    return dispatched;
+}
+
+void remoteObserveStop(AwaServerSession *session) {
+    int index;
+
+    for (index = 0; session != NULL && index < REMOTE_OBSERVE_MAX_NODES; index++) {
+        if (nodes[index].active) {
+            performObserve(session, &nodes[index], true);
+            nodes[index].active = false;
+        }
+    }
+}
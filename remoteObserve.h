@@ -0,0 +1,73 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file remoteObserve.h
+ * @brief Notification driven ingestion of sensor values from a remote LwM2M node.
+ */
+
+#ifndef REMOTE_OBSERVE_H
+#define REMOTE_OBSERVE_H
+
+#include <stdbool.h>
+#include <awa/server.h>
+
+/** Maximum number of observed sensor values of a node. */
+#define REMOTE_OBSERVE_MAX_OBSERVATIONS (8)
+/** Maximum number of nodes observed at once. */
+#define REMOTE_OBSERVE_MAX_NODES        (64)
+/** How long a single call of remoteObserveProcess() waits for notifications, in ms. */
+#define REMOTE_OBSERVE_PROCESS_TIMEOUT  (1000)
+/** Observations are registered again when nothing arrives for this many pmax periods. */
+#define REMOTE_OBSERVE_PMAX_TOLERANCE   (3)
+
+/** LwM2M notification attributes, negative values are not written to the node. */
+typedef struct {
+    int pmin;       /**< minimum period between notifications, in seconds */
+    int pmax;       /**< maximum period between notifications, in seconds */
+    double step;    /**< minimum change of value triggering a notification */
+} ObserveAttributes;
+
+/** Called for every sensor value notified by a node, with the context the node was observed with. */
+typedef void (*RemoteValueHandler)(void *context, int objectId, int instance, double value);
+
+/** Add sensor value (5700) of /objectId/instance to the set observed on every node. */
+bool remoteObserveAdd(int objectId, int instance);
+
+/** Set notification attributes written to the nodes and the handler of their notifications. */
+void remoteObserveConfigure(const ObserveAttributes *attributes, RemoteValueHandler handler);
+
+/** Write notification attributes and register all observations of the node with one observe operation. */
+bool remoteObserveStart(AwaServerSession *session, const char *clientId, void *context);
+
+/** Cancel observations of the node, e.g. when it deregistered. */
+void remoteObserveCancel(AwaServerSession *session, const char *clientId);
+
+/**
+ * Wait for notifications and dispatch them to the handler, along with other callbacks of the session. Observations
+ * of a node are registered again when it stays silent for too long, e.g. because it rebooted. Returns number of
+ * values dispatched.
+ */
+int remoteObserveProcess(AwaServerSession *session);
+
+/** Cancel observations of all nodes. */
+void remoteObserveStop(AwaServerSession *session);
+
+#endif  /* REMOTE_OBSERVE_H */
@@ -0,0 +1,113 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <stdio.h>
+#include <awa/common.h>
+#include <awa/server.h>
+#include "ipsoCommon.h"
+#include "remoteRead.h"
+#include "stats.h"
+#include "log.h"
+
+static char objectPaths[REMOTE_READ_MAX_OBJECTS][IPSO_PATH_SIZE];
+static int objectIds[REMOTE_READ_MAX_OBJECTS];
+static int objectCount = 0;
+
+bool remoteReadRequireObject(int objectId) {
+    int index;
+    for (index = 0; index < objectCount; index++) {
+        if (objectIds[index] == objectId) {
+            return true;
+        }
+    }
+
+    if (objectCount >= REMOTE_READ_MAX_OBJECTS) {
+        LOG(LOG_ERROR, "Too many remote objects, /%d won't be read", objectId);
+        return false;
+    }
+
+    objectIds[objectCount] = objectId;
+    sprintf(objectPaths[objectCount], "/%d", objectId);
+    objectCount++;
+    return true;
+}
+
+AwaError remoteReadPerform(RemoteRead *read, AwaServerSession *session, const char *clientId, int timeoutMs) {
+    int index;
+
+    remoteReadFinish(read);
+    if (objectCount == 0) {
+        return AwaError_Success;
+    }
+
+    read->operation = AwaServerReadOperation_New(session);
+    if (read->operation == NULL) {
+        LOG(LOG_ERROR, "AwaServerReadOperation_New() failed");
+        return AwaError_OutOfMemory;
+    }
+
+    for (index = 0; index < objectCount; index++) {
+        if (AwaServerReadOperation_AddPath(read->operation, clientId, objectPaths[index]) != AwaError_Success) {
+            LOG(LOG_ERROR, "Can't read %s from %s", objectPaths[index], clientId);
+        }
+    }
+
+    // AwaError_Response means only some of the objects are missing on the node, the rest is still usable
+    int64_t start = statsStart();
+    AwaError result = AwaServerReadOperation_Perform(read->operation, timeoutMs);
+    statsRecord(StatsStage_RemoteRead, start,
+                result == AwaError_Response ? StatsOutcome_Ok : statsAwaOutcome(result));
+    LOG(LOG_DEBUG, "Awa remote read of %d objects from %s: %d", objectCount, clientId, result);
+    if (result == AwaError_Success || result == AwaError_Response) {
+        read->response = AwaServerReadOperation_GetResponse(read->operation, clientId);
+    }
+
+    if (read->response == NULL) {
+        LOG(LOG_ERROR, "Reading from %s failed: %d", clientId, result);
+        remoteReadFinish(read);
+        return result == AwaError_Success || result == AwaError_Response ? AwaError_Response : result;
+    }
+    return result;
+}
+
+bool remoteReadGetValue(const RemoteRead *read, const char *path, double *value) {
+    const AwaFloat *awaValue = NULL;
+
+    if (read->response == NULL) {
+        return false;
+    }
+
+    if (AwaServerReadResponse_GetValueAsFloatPointer(read->response, path, &awaValue) != AwaError_Success) {
+        LOG(LOG_WARN, "No remote value of %s", path);
+        return false;
+    }
+
+    *value = *awaValue;
+    LOG(LOG_DEBUG, "Remote value of %s: %f", path, *value);
+    return true;
+}
+
+void remoteReadFinish(RemoteRead *read) {
+    read->response = NULL;
+    if (read->operation != NULL) {
+        AwaServerReadOperation_Free(&read->operation);
+        read->operation = NULL;
+    }
+}
@@ -0,0 +1,58 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file remoteRead.h
+ * @brief Reads all IPSO objects needed from a remote LwM2M node with a single server read operation.
+ */
+
+#ifndef REMOTE_READ_H
+#define REMOTE_READ_H
+
+#include <stdbool.h>
+#include <awa/common.h>
+#include <awa/server.h>
+
+/** Maximum number of distinct IPSO objects read from a node. */
+#define REMOTE_READ_MAX_OBJECTS (8)
+
+/** Read in progress, one per thread reading nodes. Zero initialized before the first use. */
+typedef struct {
+    AwaServerReadOperation *operation;
+    const AwaServerReadResponse *response;
+} RemoteRead;
+
+/** Add object to the set read from the nodes on every cycle, duplicates are ignored. Called before reads start. */
+bool remoteReadRequireObject(int objectId);
+
+/**
+ * Read all required objects of the node with one operation waiting up to timeoutMs. Response is kept until
+ * remoteReadFinish() or the next call, the operation is released straight away when read fails. Returns result of
+ * the operation, AwaError_Response when some of the objects are missing on the node.
+ */
+AwaError remoteReadPerform(RemoteRead *read, AwaServerSession *session, const char *clientId, int timeoutMs);
+
+/** Get value of resource path, e.g. "/3303/0/5700", from the last response. */
+bool remoteReadGetValue(const RemoteRead *read, const char *path, double *value);
+
+/** Release operation of the last read. */
+void remoteReadFinish(RemoteRead *read);
+
+#endif  /* REMOTE_READ_H */
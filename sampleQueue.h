@@ -0,0 +1,64 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file sampleQueue.h
+ * @brief Lock-free single-producer/single-consumer ring buffer of timestamped samples.
+ */
+
+#ifndef SAMPLE_QUEUE_H
+#define SAMPLE_QUEUE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <time.h>
+
+/** Capacity of a queue, has to be a power of two. */
+#define SAMPLE_QUEUE_SIZE   (64)
+#define CACHE_LINE_SIZE     (64)
+
+typedef struct {
+    struct timespec timestamp;  /**< wall clock time of acquisition */
+    int objectId;
+    int instance;
+    double value;               /**< measured value or mean of the aggregation window */
+    double min;                 /**< extremes within the window, equal to value for a single reading */
+    double max;
+    double stddev;
+    unsigned int count;         /**< number of readings aggregated */
+} Sample;
+
+typedef struct {
+    Sample samples[SAMPLE_QUEUE_SIZE];
+    /* producer and consumer indexes live on their own cache lines */
+    _Alignas(CACHE_LINE_SIZE) atomic_uint head;
+    _Alignas(CACHE_LINE_SIZE) atomic_uint tail;
+    unsigned long dropped;      /**< samples lost because the queue was full, producer side only */
+} SampleQueue;
+
+void sampleQueueInit(SampleQueue *queue);
+
+/** Producer side. Fails when the queue is full. */
+bool sampleQueuePush(SampleQueue *queue, const Sample *sample);
+
+/** Consumer side. Fails when the queue is empty. */
+bool sampleQueuePop(SampleQueue *queue, Sample *sample);
+
+#endif  /* SAMPLE_QUEUE_H */
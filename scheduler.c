@@ -0,0 +1,156 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "scheduler.h"
+#include "log.h"
+
+#define NSEC_PER_MSEC   (1000000L)
+#define NSEC_PER_SEC    (1000000000L)
+
+static int64_t virtualMs = -1;   // negative while on the real clock
+
+static pthread_once_t stopOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t stopMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stopCondition;
+static bool stopping = false;
+
+static int64_t toMs(const struct timespec *time) {
+    return (int64_t)time->tv_sec * 1000 + time->tv_nsec / NSEC_PER_MSEC;
+}
+
+static void addMs(struct timespec *time, int64_t ms) {
+    time->tv_sec += ms / 1000;
+    time->tv_nsec += (ms % 1000) * NSEC_PER_MSEC;
+    if (time->tv_nsec >= NSEC_PER_SEC) {
+        time->tv_sec++;
+        time->tv_nsec -= NSEC_PER_SEC;
+    }
+}
+
+static void initStop(void) {
+    pthread_condattr_t attributes;
+
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&stopCondition, &attributes);
+    pthread_condattr_destroy(&attributes);
+}
+
+/**
+ * Sleep until the CLOCK_MONOTONIC deadline, or until schedulerStop() was called. Timed wait on a condition variable
+ * using CLOCK_MONOTONIC takes the absolute deadline just as clock_nanosleep(TIMER_ABSTIME) did, which stop couldn't
+ * interrupt.
+ */
+static void sleepUntil(const struct timespec *deadline) {
+    pthread_once(&stopOnce, initStop);
+    pthread_mutex_lock(&stopMutex);
+    while (!stopping && pthread_cond_timedwait(&stopCondition, &stopMutex, deadline) != ETIMEDOUT);
+    pthread_mutex_unlock(&stopMutex);
+}
+
+int64_t schedulerNowMs(void) {
+    struct timespec now;
+
+    if (virtualMs >= 0) {
+        return virtualMs;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return toMs(&now);
+}
+
+void schedulerSetVirtualMs(int64_t ms) {
+    virtualMs = ms;
+}
+
+void timerStart(PeriodicTimer *timer, long periodMs) {
+    struct timespec wallClock;
+
+    memset(timer, 0, sizeof(*timer));
+    timer->periodMs = periodMs > 0 ? periodMs : 1;
+
+    clock_gettime(CLOCK_REALTIME, &wallClock);
+    clock_gettime(CLOCK_MONOTONIC, &timer->deadline);
+    addMs(&timer->deadline, timer->periodMs - toMs(&wallClock) % timer->periodMs);
+}
+
+unsigned long timerWait(PeriodicTimer *timer) {
+    unsigned long skipped = 0;
+    int64_t lateness = schedulerNowMs() - toMs(&timer->deadline);
+
+    timer->cycles++;
+    if (lateness > 0 && timer->cycles > 1) {
+        // the cycle ended after its successor should have started, that one runs straight away and periods missed
+        // entirely are dropped
+        skipped = lateness / timer->periodMs;
+        timer->overruns++;
+        timer->skipped += skipped;
+        if (lateness > timer->maxLatenessMs) {
+            timer->maxLatenessMs = lateness;
+        }
+        addMs(&timer->deadline, (int64_t)skipped * timer->periodMs);
+        LOG(LOG_WARN, "Cycle overran its %ld ms period by %lld ms, %lu overruns so far",
+            timer->periodMs, (long long)lateness, timer->overruns);
+    }
+
+    sleepUntil(&timer->deadline);
+    addMs(&timer->deadline, timer->periodMs);
+    return skipped;
+}
+
+void schedulerSleepMs(long ms) {
+    struct timespec deadline;
+
+    if (virtualMs >= 0) {
+        virtualMs += ms;
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    addMs(&deadline, ms);
+    sleepUntil(&deadline);
+}
+
+void schedulerStop(void) {
+    pthread_once(&stopOnce, initStop);
+    pthread_mutex_lock(&stopMutex);
+    stopping = true;
+    pthread_cond_broadcast(&stopCondition);
+    pthread_mutex_unlock(&stopMutex);
+}
+
+long parsePeriodMs(const char *text) {
+    char *end = NULL;
+    double value = strtod(text, &end);
+
+    if (end == text || value <= 0) {
+        return -1;
+    }
+    if (strcmp(end, "ms") == 0) {
+        return (long)value;
+    }
+    if (*end == '\0' || strcmp(end, "s") == 0) {
+        return (long)(value * 1000);
+    }
+    return -1;
+}
@@ -0,0 +1,75 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file scheduler.h
+ * @brief Drift-free periodic timers on CLOCK_MONOTONIC with absolute deadlines and overrun accounting.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+typedef struct {
+    struct timespec deadline;   /**< absolute CLOCK_MONOTONIC time of the next cycle */
+    long periodMs;
+    unsigned long cycles;
+    unsigned long overruns;     /**< cycles which ended after the next deadline */
+    unsigned long skipped;      /**< whole periods skipped to get back in phase */
+    long maxLatenessMs;         /**< worst lateness seen, in ms */
+} PeriodicTimer;
+
+/**
+ * Start timer. First deadline is aligned to a multiple of the period in wall clock time, so gateways sampling with
+ * the same period stay in phase with each other.
+ */
+void timerStart(PeriodicTimer *timer, long periodMs);
+
+/**
+ * Sleep until the next deadline. When the cycle overran, the next one starts at once, periods missed entirely are
+ * skipped keeping the original phase and the overrun is accounted. Returns number of skipped periods.
+ */
+unsigned long timerWait(PeriodicTimer *timer);
+
+/** Sleep for ms milliseconds, resuming after signals. */
+void schedulerSleepMs(long ms);
+
+/** Wake up every thread sleeping in timerWait() or schedulerSleepMs(), later sleeps return at once. For shutdown. */
+void schedulerStop(void);
+
+/** Current CLOCK_MONOTONIC time in ms, or the virtual time once it was set. */
+int64_t schedulerNowMs(void);
+
+/**
+ * Switch to virtual time, which stands still until set again and is advanced by schedulerSleepMs() without sleeping.
+ * Used by trace replay, which runs on the main thread alone.
+ */
+void schedulerSetVirtualMs(int64_t ms);
+
+/**
+ * Parse period given as seconds ("5", "2.5", "5s") or milliseconds ("500ms"). Returns period in ms, or -1 when it
+ * is not valid.
+ */
+long parsePeriodMs(const char *text);
+
+#endif  /* SCHEDULER_H */
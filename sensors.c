@@ -0,0 +1,402 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <letmecreate/letmecreate.h>
+#include "sensors.h"
+#include "bme280.h"
+#include "thunder.h"
+#include "stats.h"
+#include "trace.h"
+#include "log.h"
+
+//! \{
+#define SENSORS_MAX_OBJECTS (8)
+/** Polling interval of a forced conversion overrunning its typical time. */
+#define BME280_POLL_US      (500)
+/** Slack over the maximum conversion time before the conversion is given up. */
+#define BME280_SLACK_MS     (5)
+//! \}
+
+//LetMeCreate keeps selected I2C bus globally, slot producers must not interleave their transactions
+static pthread_mutex_t i2cMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//deadline of the read running on each bus, a bus held by a hung read is not waited for past it
+static struct timespec busDeadlines[MIKROBUS_COUNT];
+
+//read on each bus gave up waiting for the bus, another slot is to blame for it
+static bool busTimedOut[MIKROBUS_COUNT];
+
+//next free instance id of every object fed by attached slots
+static struct {
+    int objectId;
+    int next;
+} instanceIds[SENSORS_MAX_OBJECTS];
+static int instanceIdCount = 0;
+
+//acquisition profile of the Weather click on each bus
+static const Bme280Profile *weatherProfiles[MIKROBUS_COUNT];
+
+/** Take the I2C bus and select it, false when it stays held by another slot past the deadline of the read. */
+static bool lockBus(uint8_t bus) {
+    if (busDeadlines[bus].tv_sec == 0) {
+        pthread_mutex_lock(&i2cMutex);
+    } else if (pthread_mutex_timedlock(&i2cMutex, &busDeadlines[bus]) != 0) {
+        LOG(LOG_WARN, "I2C bus busy past deadline of the read on bus#%d", bus);
+        busTimedOut[bus] = true;
+        return false;
+    }
+    i2c_select_bus(bus);
+    return true;
+}
+
+static void unlockBus(void) {
+    pthread_mutex_unlock(&i2cMutex);
+}
+
+static bool readThermo3(uint8_t bus, double *values) {
+    LOG(LOG_DEBUG, "Reading thermo3 on bus#%d", bus);
+    float temperature = 0.f;
+
+    if (!lockBus(bus)) {
+        return false;
+    }
+    thermo3_click_enable(0);
+    int result = thermo3_click_get_temperature(&temperature);
+    thermo3_click_disable();
+    unlockBus();
+
+    values[0] = temperature;
+    return result >= 0;
+}
+
+/**
+ * Run single forced conversion, the bus is released while it runs so the other slot can go on. Sleeps the typical
+ * conversion time, then polls the status up to the maximum one.
+ */
+static bool convertWeather(uint8_t bus, const Bme280Profile *profile, double *elapsedMs) {
+    int64_t start = statsStart();
+    int64_t deadline = start + (int64_t)((bme280ConversionMs(profile, true) + BME280_SLACK_MS) * 1000);
+    bool measuring = true;
+
+    if (!lockBus(bus)) {
+        return false;
+    }
+    bool result = bme280Start(profile, Bme280Mode_Forced);
+    unlockBus();
+
+    usleep((useconds_t)(bme280ConversionMs(profile, false) * 1000));
+    while (result) {
+        if (!lockBus(bus)) {
+            return false;
+        }
+        result = bme280Measuring(&measuring);
+        unlockBus();
+        if (!result || !measuring) {
+            break;
+        }
+        if (statsStart() > deadline) {
+            LOG(LOG_WARN, "Weather conversion on bus#%d overran %.1f ms", bus, bme280ConversionMs(profile, true));
+            return false;
+        }
+        usleep(BME280_POLL_US);
+    }
+    *elapsedMs = (statsStart() - start) / 1000.0;
+    return result;
+}
+
+static bool initWeather(uint8_t bus, const char *profileName, long periodMs) {
+    const Bme280Profile *profile = profileName != NULL ? bme280ProfileFind(profileName) :
+                                   bme280ProfileForPeriod(periodMs);
+    double elapsedMs = 0;
+
+    if (profile == NULL) {
+        return false;
+    }
+
+    if (!lockBus(bus)) {
+        return false;
+    }
+    bool result = weather_click_enable() >= 0 && bme280Configure(profile);
+    unlockBus();
+
+    // a forced conversion tells the conversion time of either mode
+    if (!result || !convertWeather(bus, profile, &elapsedMs)) {
+        return false;
+    }
+    if (profile->mode == Bme280Mode_Normal) {
+        if (!lockBus(bus)) {
+            return false;
+        }
+        result = bme280Start(profile, Bme280Mode_Normal);
+        unlockBus();
+    }
+
+    LOG(LOG_INFO, "Weather on bus#%d uses %s profile: %s mode, oversampling t%d p%d h%d, filter %d, conversion %.1f ms "
+        "(typical %.1f ms, max %.1f ms)", bus, profile->name, profile->mode == Bme280Mode_Forced ? "forced" : "normal",
+        profile->temperatureOversampling, profile->pressureOversampling, profile->humidityOversampling,
+        profile->filter, elapsedMs, bme280ConversionMs(profile, false), bme280ConversionMs(profile, true));
+    weatherProfiles[bus] = profile;
+    return result;
+}
+
+static bool readWeather(uint8_t bus, double *values) {
+    LOG(LOG_DEBUG, "Reading weather on bus#%d", bus);
+    const Bme280Profile *profile = weatherProfiles[bus];
+    double elapsedMs = 0;
+    int result = -1;
+
+    if (profile == NULL) {
+        return false;
+    }
+
+    if ((profile->mode == Bme280Mode_Normal || convertWeather(bus, profile, &elapsedMs)) && lockBus(bus)) {
+        result = weather_click_read_measurements(&values[0], &values[1], &values[2]);
+        unlockBus();
+    }
+    if (result < 0) {
+        return false;
+    }
+
+    // registers of skipped channels hold no measurement
+    if (profile->pressureOversampling == 0) {
+        values[1] = NAN;
+    }
+    if (profile->humidityOversampling == 0) {
+        values[2] = NAN;
+    }
+    LOG(LOG_DEBUG, "Weather measurements: temp = %f, pressure = %f, humidity = %f, conversion %.1f ms", values[0],
+        values[1], values[2], elapsedMs);
+    return true;
+}
+
+static void releaseWeather(uint8_t bus) {
+    if (lockBus(bus)) {
+        weather_click_disable();
+        unlockBus();
+    }
+}
+
+static bool readCO(uint8_t bus, double *values) {
+    LOG(LOG_DEBUG, "Reading CO on bus#%d", bus);
+    uint16_t value = 0;
+
+    int result = co_click_get_measure(bus, &value);
+
+    values[0] = value;
+    return result >= 0;
+}
+
+static bool readAirQuality(uint8_t bus, double *values) {
+    LOG(LOG_DEBUG, "Reading air quality on bus#%d", bus);
+    uint16_t value = 0;
+
+    int result = air_quality_click_get_measure(bus, &value);
+
+    values[0] = value;
+    return result >= 0;
+}
+
+static bool initThunder(uint8_t bus, const char *profile, long periodMs) {
+    (void)profile;
+    (void)periodMs;
+    return thunderStart(bus);
+}
+
+static bool waitThunder(uint8_t bus, int timeoutMs, double *values) {
+    ThunderStrike strike;
+
+    (void)bus;
+    if (!thunderWaitStrike(timeoutMs, &strike)) {
+        return false;
+    }
+    if (strike.distance == THUNDER_DISTANCE_OUT_OF_RANGE) {
+        LOG(LOG_INFO, "Lightning out of range, not published");
+        return false;
+    }
+    values[0] = strike.distance;
+    values[1] = strike.energy;
+    statsRecord(StatsStage_Event, strike.interruptUs, StatsOutcome_Ok);
+    return true;
+}
+
+static void releaseThunder(uint8_t bus) {
+    (void)bus;
+    thunderStop();
+}
+
+// thunder feeds distance of the strike to 3330 and its energy to 3328
+static const SensorType sensorTypes[] = {
+    { "air", 1, {{ 3325, "ppm" }}, NULL, &readAirQuality, NULL, NULL },
+    { "co", 1, {{ 3325, "ppm" }}, NULL, &readCO, NULL, NULL },
+    { "thermo3", 1, {{ 3303, "Cel" }}, NULL, &readThermo3, NULL, NULL },
+    { "thunder", 2, {{ 3330, "km" }, { 3328, NULL }}, &initThunder, NULL, &releaseThunder, &waitThunder },
+    { "weather", 3, {{ 3303, "Cel" }, { 3315, "Pa" }, { 3304, "%RH" }}, &initWeather, &readWeather, &releaseWeather,
+      NULL },
+};
+
+const SensorType *sensorTypeFind(const char *name) {
+    size_t index;
+
+    for (index = 0; index < sizeof(sensorTypes) / sizeof(sensorTypes[0]); index++) {
+        if (strcasecmp(sensorTypes[index].name, name) == 0) {
+            return &sensorTypes[index];
+        }
+    }
+    if (strcasecmp(name, "none") != 0) {
+        LOG(LOG_WARN, "Unknown click %s, slot left empty", name);
+    }
+    return NULL;
+}
+
+static int allocateInstance(int objectId) {
+    int index;
+
+    for (index = 0; index < instanceIdCount; index++) {
+        if (instanceIds[index].objectId == objectId) {
+            return instanceIds[index].next++;
+        }
+    }
+    if (instanceIdCount == SENSORS_MAX_OBJECTS) {
+        LOG(LOG_ERROR, "Too many objects, /%d shares instance 0", objectId);
+        return 0;
+    }
+    instanceIds[instanceIdCount].objectId = objectId;
+    instanceIds[instanceIdCount].next = 1;
+    instanceIdCount++;
+    return 0;
+}
+
+void sensorSlotAttach(SensorSlot *slot, const SensorType *type, uint8_t bus) {
+    int index;
+
+    slot->type = type;
+    slot->bus = bus;
+    slot->profile = NULL;
+    slot->periodMs = 0;
+    slot->channelCount = type != NULL ? type->outputCount : 0;
+    for (index = 0; index < slot->channelCount; index++) {
+        SensorChannel *channel = &slot->channels[index];
+        channel->objectId = type->outputs[index].objectId;
+        channel->instance = allocateInstance(channel->objectId);
+        channel->units = type->outputs[index].units;
+        sprintf(channel->valuePath, "/%d/%d/%d", channel->objectId, channel->instance, IPSO_RESOURCE_SENSOR_VALUE);
+    }
+}
+
+int sensorObjectInstances(int objectId) {
+    int index;
+
+    for (index = 0; index < instanceIdCount; index++) {
+        if (instanceIds[index].objectId == objectId) {
+            return instanceIds[index].next;
+        }
+    }
+    return 0;
+}
+
+bool sensorSlotSampled(const SensorSlot *slot) {
+    return slot->type != NULL && slot->type->read != NULL;
+}
+
+bool sensorSlotEventDriven(const SensorSlot *slot) {
+    return slot->type != NULL && slot->type->waitEvent != NULL;
+}
+
+bool sensorSlotInit(const SensorSlot *slot) {
+    if (slot->type == NULL || slot->type->init == NULL) {
+        return true;
+    }
+    if (!slot->type->init(slot->bus, slot->profile, slot->periodMs)) {
+        LOG(LOG_ERROR, "Failed to enable %s click on bus#%d", slot->type->name, slot->bus);
+        return false;
+    }
+    return true;
+}
+
+static void traceValues(const SensorSlot *slot, const double *values) {
+    int index;
+
+    if (!traceRecording()) {
+        return;
+    }
+    for (index = 0; index < slot->channelCount; index++) {
+        if (!isnan(values[index])) {
+            traceRead(slot->channels[index].objectId, slot->channels[index].instance, values[index]);
+        }
+    }
+}
+
+SensorReadResult sensorSlotRead(const SensorSlot *slot, long deadlineMs, double *values) {
+    if (!sensorSlotSampled(slot)) {
+        return SensorRead_Failed;
+    }
+
+    int64_t start = statsStart();
+    clock_gettime(CLOCK_REALTIME, &busDeadlines[slot->bus]);
+    busDeadlines[slot->bus].tv_sec += deadlineMs / 1000;
+    busDeadlines[slot->bus].tv_nsec += (deadlineMs % 1000) * 1000000;
+    if (busDeadlines[slot->bus].tv_nsec >= 1000000000) {
+        busDeadlines[slot->bus].tv_sec++;
+        busDeadlines[slot->bus].tv_nsec -= 1000000000;
+    }
+    busTimedOut[slot->bus] = false;
+    bool result = slot->type->read(slot->bus, values);
+    bool late = statsStart() - start > (int64_t)deadlineMs * 1000;
+    busDeadlines[slot->bus].tv_sec = 0;
+    statsRecord(StatsStage_SensorRead, start, late || busTimedOut[slot->bus] ? StatsOutcome_Timeout :
+                result ? StatsOutcome_Ok : StatsOutcome_Error);
+
+    if (busTimedOut[slot->bus]) {
+        LOG(LOG_WARN, "Reading %s on bus#%d skipped, the I2C bus is held by another slot", slot->type->name,
+            slot->bus);
+        return SensorRead_BusBusy;
+    }
+    if (!result) {
+        LOG(LOG_ERROR, "Reading %s on bus#%d failed!", slot->type->name, slot->bus);
+        return SensorRead_Failed;
+    }
+    if (late) {
+        LOG(LOG_ERROR, "Reading %s on bus#%d missed its deadline of %ld ms", slot->type->name, slot->bus, deadlineMs);
+        return SensorRead_Failed;
+    }
+    traceValues(slot, values);
+    return SensorRead_Ok;
+}
+
+bool sensorSlotWaitEvent(const SensorSlot *slot, int timeoutMs, double *values) {
+    if (!sensorSlotEventDriven(slot) || !slot->type->waitEvent(slot->bus, timeoutMs, values)) {
+        return false;
+    }
+    traceValues(slot, values);
+    return true;
+}
+
+void sensorSlotRelease(const SensorSlot *slot) {
+    if (slot->type != NULL && slot->type->release != NULL) {
+        slot->type->release(slot->bus);
+    }
+}
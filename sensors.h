@@ -0,0 +1,108 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file sensors.h
+ * @brief Registry of supported clicks: what they measure, how to read them and the IPSO instances they feed.
+ */
+
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ipsoCommon.h"
+
+/** Maximum number of IPSO objects produced by a single click. */
+#define SENSOR_MAX_CHANNELS (3)
+
+typedef struct {
+    int objectId;
+    const char *units;
+} SensorOutput;
+
+typedef struct {
+    const char *name;                           /**< value of --click1/--click2 */
+    int outputCount;
+    SensorOutput outputs[SENSOR_MAX_CHANNELS];
+    bool (*init)(uint8_t bus, const char *profile, long periodMs);  /**< NULL when the click needs no setup */
+    /** Fills value of every output, NAN for outputs the profile doesn't measure. NULL when not sampled. */
+    bool (*read)(uint8_t bus, double *values);
+    void (*release)(uint8_t bus);               /**< NULL when the click needs no teardown */
+    /** Block until the click reports an event with values of all outputs, NULL when not event driven. */
+    bool (*waitEvent)(uint8_t bus, int timeoutMs, double *values);
+} SensorType;
+
+typedef enum {
+    SensorRead_Ok,
+    SensorRead_Failed,
+    SensorRead_BusBusy      /**< the I2C bus stayed held by another slot past the deadline */
+} SensorReadResult;
+
+/** IPSO instance fed by a click, with its path resolved when the click is attached. */
+typedef struct {
+    int objectId;
+    int instance;
+    const char *units;
+    char valuePath[IPSO_PATH_SIZE];
+} SensorChannel;
+
+typedef struct {
+    const SensorType *type;     /**< NULL for empty slot */
+    uint8_t bus;
+    const char *profile;        /**< acquisition profile, NULL picks one by periodMs */
+    long periodMs;              /**< time between reads */
+    int channelCount;
+    SensorChannel channels[SENSOR_MAX_CHANNELS];
+} SensorSlot;
+
+/** Find click type by name, NULL for "none" and unknown names. */
+const SensorType *sensorTypeFind(const char *name);
+
+/**
+ * Bind click type to a slot and allocate its IPSO instances, each object gets the next free instance id across all
+ * slots attached so far. Type may be NULL for an empty slot. Profile and period of reads are left for the caller.
+ */
+void sensorSlotAttach(SensorSlot *slot, const SensorType *type, uint8_t bus);
+
+/** Number of instances of the object fed by all slots attached so far. */
+int sensorObjectInstances(int objectId);
+
+/** True when the slot holds a click which is sampled periodically. */
+bool sensorSlotSampled(const SensorSlot *slot);
+
+/** True when the slot holds a click which reports events on its own. */
+bool sensorSlotEventDriven(const SensorSlot *slot);
+
+bool sensorSlotInit(const SensorSlot *slot);
+
+/**
+ * Read all channels of the slot, safe to call from producers of different slots at once. A read which doesn't get the
+ * I2C bus within deadlineMs gives up with SensorRead_BusBusy, the slot holding the bus is the one at fault. A read which
+ * takes longer than deadlineMs on its own fails once it returns.
+ */
+SensorReadResult sensorSlotRead(const SensorSlot *slot, long deadlineMs, double *values);
+
+/** Wait up to timeoutMs for the next event of the slot, false on timeout and on events not worth publishing. */
+bool sensorSlotWaitEvent(const SensorSlot *slot, int timeoutMs, double *values);
+
+void sensorSlotRelease(const SensorSlot *slot);
+
+#endif  /* SENSORS_H */
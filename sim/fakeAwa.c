@@ -0,0 +1,1121 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * Stand-in for the Awa client and server APIs. The client side keeps an in-process resource store of the objects the
+ * daemon defined, it starts without any like a fresh client daemon. The server side serves remote clients described by
+ * the scenario.
+ * Every Perform() honours the scripted latency and outage, so the daemon's reconnect and spool paths run as with the
+ * real daemons.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <awa/common.h>
+#include <awa/client.h>
+#include <awa/server.h>
+#include "simControl.h"
+
+//! \{
+#define FAKE_MAX_INSTANCES      (32)
+#define FAKE_MAX_RESOURCES      (256)
+#define FAKE_MAX_ACTIONS        (128)
+#define FAKE_MAX_OBSERVATIONS   (64)
+#define FAKE_MAX_CLIENTS        (32)
+#define FAKE_MAX_MANDATORY      (8)
+#define FAKE_MAX_OBJECTS        (16)
+#define FAKE_NOTIFY_PERIOD_MS   (250)
+#define FAKE_SENSOR_VALUE       (5700)
+//! \}
+
+typedef struct {
+    int id;
+    int mandatory[FAKE_MAX_MANDATORY];
+    int mandatoryCount;
+} FakeObject;
+
+struct _AwaObjectDefinition {
+    FakeObject object;
+};
+
+typedef struct {
+    char path[SIM_PATH_SIZE];
+    double value;
+} StoredResource;
+
+typedef enum {
+    Action_CreateInstance,
+    Action_CreateResource,
+    Action_SetValue,
+    Action_GetValue
+} ActionType;
+
+struct _AwaPathResult {
+    AwaError error;
+};
+
+typedef struct {
+    ActionType type;
+    char path[SIM_PATH_SIZE];
+    double value;
+    AwaPathResult result;
+} Action;
+
+struct _AwaClientSession {
+    bool connected;
+};
+
+struct _AwaClientSetResponse {
+    Action actions[FAKE_MAX_ACTIONS];
+    int count;
+};
+
+struct _AwaClientSetOperation {
+    AwaClientSetResponse response;
+};
+
+struct _AwaClientGetResponse {
+    Action actions[FAKE_MAX_ACTIONS];
+    int count;
+};
+
+struct _AwaClientGetOperation {
+    AwaClientGetResponse response;
+};
+
+struct _AwaClientDefineOperation {
+    FakeObject objects[FAKE_MAX_OBJECTS];
+    int count;
+};
+
+typedef struct {
+    char clientIds[FAKE_MAX_CLIENTS][SIM_CLIENT_ID_SIZE];
+    int count;
+} ClientList;
+
+struct _AwaClientIterator {
+    ClientList list;
+    int position;
+};
+
+struct _AwaServerListClientsOperation {
+    ClientList clients;
+    bool performed;
+};
+
+// both events carry a single client
+struct _AwaServerClientRegisterEvent {
+    ClientList clients;
+};
+
+struct _AwaServerClientDeregisterEvent {
+    ClientList clients;
+};
+
+struct _AwaServerSession {
+    bool connected;
+    AwaChangeSet *pending[FAKE_MAX_OBSERVATIONS];
+    int pendingCount;
+    int64_t nextNotifyMs;
+    AwaServerClientRegisterEventCallback registerCallback;
+    void *registerContext;
+    AwaServerClientDeregisterEventCallback deregisterCallback;
+    void *deregisterContext;
+    int nextEvent;                  /**< first scripted event not looked at yet */
+    const SimEvent *pendingEvents[FAKE_MAX_CLIENTS];
+    int pendingEventCount;
+};
+
+struct _AwaServerReadResponse {
+    char clientId[SIM_CLIENT_ID_SIZE];
+    char paths[FAKE_MAX_ACTIONS][SIM_PATH_SIZE];
+    double values[FAKE_MAX_ACTIONS];
+    int count;
+};
+
+struct _AwaServerReadOperation {
+    AwaServerReadResponse response;
+    bool performed;
+};
+
+struct _AwaChangeSet {
+    char path[SIM_PATH_SIZE];
+    double value;
+};
+
+struct _AwaServerObservation {
+    char clientId[SIM_CLIENT_ID_SIZE];
+    char path[SIM_PATH_SIZE];
+    AwaServerObservationCallback callback;
+    void *context;
+    bool active;
+    AwaChangeSet changeSet;
+};
+
+struct _AwaServerObserveOperation {
+    AwaServerObservation *observations[FAKE_MAX_OBSERVATIONS];
+    bool cancel[FAKE_MAX_OBSERVATIONS];
+    int count;
+};
+
+struct _AwaServerWriteAttributesOperation {
+    char clientIds[FAKE_MAX_ACTIONS][SIM_CLIENT_ID_SIZE];
+    int count;
+};
+
+// objects with resources created along with their instances
+static FakeObject definedObjects[FAKE_MAX_OBJECTS];
+static int definedObjectCount = 0;
+static char instances[FAKE_MAX_INSTANCES][SIM_PATH_SIZE];
+static int instanceCount = 0;
+static StoredResource resources[FAKE_MAX_RESOURCES];
+static int resourceCount = 0;
+static AwaServerObservation *observations[FAKE_MAX_OBSERVATIONS];
+static int observationCount = 0;
+
+/** Delay and outage shared by all operations, returns error to report or success. */
+static AwaError performTransport(SimCounter counter) {
+    simSleepMs(g_SimConfig.awaLatencyMs);
+    simCount(counter);
+    if (simAwaOutage()) {
+        simCount(SimCounter_FailedOps);
+        return AwaError_IPCError;
+    }
+    return AwaError_Success;
+}
+
+static const FakeObject *findObject(int objectId) {
+    int i;
+    for (i = 0; i < definedObjectCount; i++) {
+        if (definedObjects[i].id == objectId) {
+            return &definedObjects[i];
+        }
+    }
+    return NULL;
+}
+
+static bool instanceExists(int objectId, int instance) {
+    char path[SIM_PATH_SIZE];
+    int i;
+
+    snprintf(path, sizeof(path), "/%d/%d", objectId, instance);
+    for (i = 0; i < instanceCount; i++) {
+        if (strcmp(instances[i], path) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static StoredResource *findResource(const char *path) {
+    int i;
+    for (i = 0; i < resourceCount; i++) {
+        if (strcmp(resources[i].path, path) == 0) {
+            return &resources[i];
+        }
+    }
+    return NULL;
+}
+
+static AwaError createResource(const char *path) {
+    if (findResource(path) != NULL) {
+        return AwaError_CannotCreate;
+    }
+    if (resourceCount == FAKE_MAX_RESOURCES) {
+        return AwaError_OutOfMemory;
+    }
+    snprintf(resources[resourceCount].path, SIM_PATH_SIZE, "%s", path);
+    resources[resourceCount++].value = 0;
+    return AwaError_Success;
+}
+
+static AwaError applyAction(Action *action) {
+    int objectId;
+    int instance;
+    int resource;
+    int i;
+    StoredResource *stored;
+    const FakeObject *object;
+    int fields = sscanf(action->path, "/%d/%d/%d", &objectId, &instance, &resource);
+
+    if (fields < 1 || (object = findObject(objectId)) == NULL) {
+        return AwaError_NotDefined;
+    }
+
+    switch (action->type) {
+        case Action_CreateInstance:
+            if (fields != 2) {
+                return AwaError_PathInvalid;
+            }
+            if (instanceExists(objectId, instance)) {
+                return AwaError_CannotCreate;
+            }
+            if (instanceCount == FAKE_MAX_INSTANCES) {
+                return AwaError_OutOfMemory;
+            }
+            snprintf(instances[instanceCount++], SIM_PATH_SIZE, "%s", action->path);
+            for (i = 0; i < object->mandatoryCount; i++) {
+                char mandatory[SIM_PATH_SIZE];
+                if (snprintf(mandatory, sizeof(mandatory), "%s/%d", action->path, object->mandatory[i]) >=
+                    (int)sizeof(mandatory)) {
+                    return AwaError_PathInvalid;
+                }
+                if (createResource(mandatory) != AwaError_Success) {
+                    return AwaError_OutOfMemory;
+                }
+            }
+            return AwaError_Success;
+        case Action_CreateResource:
+            if (fields != 3) {
+                return AwaError_PathInvalid;
+            }
+            if (!instanceExists(objectId, instance)) {
+                return AwaError_PathNotFound;
+            }
+            return createResource(action->path);
+        case Action_SetValue:
+        case Action_GetValue:
+            if (fields != 3) {
+                return AwaError_PathInvalid;
+            }
+            stored = findResource(action->path);
+            if (stored == NULL) {
+                return AwaError_PathNotFound;
+            }
+            if (action->type == Action_SetValue) {
+                stored->value = action->value;
+                if (resource == FAKE_SENSOR_VALUE) {
+                    simCount(SimCounter_SensorValues);
+                }
+            } else {
+                action->value = stored->value;
+            }
+            return AwaError_Success;
+    }
+    return AwaError_Internal;
+}
+
+static AwaError addAction(Action *actions, int *count, ActionType type, const char *path, double value) {
+    if (path == NULL || path[0] != '/') {
+        return AwaError_PathInvalid;
+    }
+    if (*count == FAKE_MAX_ACTIONS) {
+        return AwaError_OutOfMemory;
+    }
+    actions[*count].type = type;
+    snprintf(actions[*count].path, SIM_PATH_SIZE, "%s", path);
+    actions[*count].value = value;
+    actions[*count].result.error = AwaError_Unspecified;
+    (*count)++;
+    return AwaError_Success;
+}
+
+static AwaError performActions(Action *actions, int count) {
+    AwaError result = AwaError_Success;
+    int i;
+
+    simLock();
+    for (i = 0; i < count; i++) {
+        actions[i].result.error = applyAction(&actions[i]);
+        if (actions[i].result.error != AwaError_Success) {
+            result = AwaError_Response;
+        }
+    }
+    simUnlock();
+    return result;
+}
+
+/** Result of the last action on the path, operations may touch a path more than once. */
+static const Action *findAction(const Action *actions, int count, const char *path) {
+    int i;
+    for (i = count - 1; i >= 0; i--) {
+        if (strcmp(actions[i].path, path) == 0) {
+            return &actions[i];
+        }
+    }
+    return NULL;
+}
+
+bool fakeAwaClientValue(const char *path, double *value) {
+    StoredResource *stored;
+
+    simLock();
+    stored = findResource(path);
+    if (stored != NULL) {
+        *value = stored->value;
+    }
+    simUnlock();
+    return stored != NULL;
+}
+
+AwaError AwaPathResult_GetError(const AwaPathResult *result) {
+    return result != NULL ? result->error : AwaError_OperationInvalid;
+}
+
+AwaClientSession *AwaClientSession_New(void) {
+    return calloc(1, sizeof(AwaClientSession));
+}
+
+AwaError AwaClientSession_SetIPCAsUDP(AwaClientSession *session, const char *address, unsigned short port) {
+    (void)address;
+    (void)port;
+    return session != NULL ? AwaError_Success : AwaError_SessionInvalid;
+}
+
+AwaError AwaClientSession_Connect(AwaClientSession *session) {
+    AwaError result;
+
+    if (session == NULL) {
+        return AwaError_SessionInvalid;
+    }
+    result = performTransport(SimCounter_Connects);
+    session->connected = result == AwaError_Success;
+    return result;
+}
+
+AwaError AwaClientSession_Disconnect(AwaClientSession *session) {
+    if (session == NULL || !session->connected) {
+        return AwaError_SessionNotConnected;
+    }
+    session->connected = false;
+    return AwaError_Success;
+}
+
+AwaError AwaClientSession_Free(AwaClientSession **session) {
+    if (session == NULL || *session == NULL) {
+        return AwaError_SessionInvalid;
+    }
+    free(*session);
+    *session = NULL;
+    return AwaError_Success;
+}
+
+bool AwaClientSession_IsObjectDefined(const AwaClientSession *session, AwaObjectID objectID) {
+    bool defined;
+
+    if (session == NULL || !session->connected) {
+        return false;
+    }
+    simLock();
+    defined = findObject(objectID) != NULL;
+    simUnlock();
+    return defined;
+}
+
+AwaObjectDefinition *AwaObjectDefinition_New(AwaObjectID objectID, const char *objectName, int minimumInstances,
+                                             int maximumInstances) {
+    AwaObjectDefinition *definition = calloc(1, sizeof(AwaObjectDefinition));
+
+    (void)objectName;
+    (void)minimumInstances;
+    (void)maximumInstances;
+    if (definition != NULL) {
+        definition->object.id = objectID;
+    }
+    return definition;
+}
+
+void AwaObjectDefinition_Free(AwaObjectDefinition **objectDefinition) {
+    if (objectDefinition != NULL) {
+        free(*objectDefinition);
+        *objectDefinition = NULL;
+    }
+}
+
+/** Only mandatory resources matter, they are created along with the instance. */
+static AwaError addResourceDefinition(AwaObjectDefinition *objectDefinition, AwaResourceID resourceID,
+                                      bool isMandatory) {
+    FakeObject *object;
+
+    if (objectDefinition == NULL) {
+        return AwaError_OperationInvalid;
+    }
+    object = &objectDefinition->object;
+    if (isMandatory) {
+        if (object->mandatoryCount == FAKE_MAX_MANDATORY) {
+            return AwaError_OutOfMemory;
+        }
+        object->mandatory[object->mandatoryCount++] = resourceID;
+    }
+    return AwaError_Success;
+}
+
+AwaError AwaObjectDefinition_AddResourceDefinitionAsString(AwaObjectDefinition *objectDefinition,
+                                                           AwaResourceID resourceID, const char *resourceName,
+                                                           bool isMandatory, AwaResourceOperations operations,
+                                                           const char *defaultValue) {
+    (void)resourceName;
+    (void)operations;
+    (void)defaultValue;
+    return addResourceDefinition(objectDefinition, resourceID, isMandatory);
+}
+
+AwaError AwaObjectDefinition_AddResourceDefinitionAsInteger(AwaObjectDefinition *objectDefinition,
+                                                            AwaResourceID resourceID, const char *resourceName,
+                                                            bool isMandatory, AwaResourceOperations operations,
+                                                            AwaInteger defaultValue) {
+    (void)resourceName;
+    (void)operations;
+    (void)defaultValue;
+    return addResourceDefinition(objectDefinition, resourceID, isMandatory);
+}
+
+AwaError AwaObjectDefinition_AddResourceDefinitionAsFloat(AwaObjectDefinition *objectDefinition,
+                                                          AwaResourceID resourceID, const char *resourceName,
+                                                          bool isMandatory, AwaResourceOperations operations,
+                                                          AwaFloat defaultValue) {
+    (void)resourceName;
+    (void)operations;
+    (void)defaultValue;
+    return addResourceDefinition(objectDefinition, resourceID, isMandatory);
+}
+
+AwaClientDefineOperation *AwaClientDefineOperation_New(const AwaClientSession *session) {
+    return session != NULL && session->connected ? calloc(1, sizeof(AwaClientDefineOperation)) : NULL;
+}
+
+AwaError AwaClientDefineOperation_Add(AwaClientDefineOperation *operation, const AwaObjectDefinition *objectDefinition) {
+    if (operation == NULL || objectDefinition == NULL) {
+        return AwaError_OperationInvalid;
+    }
+    if (operation->count == FAKE_MAX_OBJECTS) {
+        return AwaError_OutOfMemory;
+    }
+    operation->objects[operation->count++] = objectDefinition->object;
+    return AwaError_Success;
+}
+
+/** Like the daemon, objects defined already are rejected while the other ones of the operation get defined. */
+AwaError AwaClientDefineOperation_Perform(AwaClientDefineOperation *operation, AwaTimeout timeout) {
+    AwaError result;
+    int i;
+
+    (void)timeout;
+    if (operation == NULL) {
+        return AwaError_OperationInvalid;
+    }
+    simCount(SimCounter_DefineOps);
+    result = performTransport(SimCounter_ClientOps);
+    if (result != AwaError_Success) {
+        return result;
+    }
+    simLock();
+    for (i = 0; i < operation->count; i++) {
+        if (findObject(operation->objects[i].id) != NULL) {
+            result = AwaError_AlreadyDefined;
+        } else if (definedObjectCount == FAKE_MAX_OBJECTS) {
+            result = AwaError_OutOfMemory;
+        } else {
+            definedObjects[definedObjectCount++] = operation->objects[i];
+        }
+    }
+    simUnlock();
+    return result;
+}
+
+AwaError AwaClientDefineOperation_Free(AwaClientDefineOperation **operation) {
+    if (operation == NULL || *operation == NULL) {
+        return AwaError_OperationInvalid;
+    }
+    free(*operation);
+    *operation = NULL;
+    return AwaError_Success;
+}
+
+AwaClientSetOperation *AwaClientSetOperation_New(const AwaClientSession *session) {
+    return session != NULL && session->connected ? calloc(1, sizeof(AwaClientSetOperation)) : NULL;
+}
+
+AwaError AwaClientSetOperation_CreateObjectInstance(AwaClientSetOperation *operation, const char *path) {
+    return addAction(operation->response.actions, &operation->response.count, Action_CreateInstance, path, 0);
+}
+
+AwaError AwaClientSetOperation_CreateOptionalResource(AwaClientSetOperation *operation, const char *path) {
+    return addAction(operation->response.actions, &operation->response.count, Action_CreateResource, path, 0);
+}
+
+AwaError AwaClientSetOperation_AddValueAsFloat(AwaClientSetOperation *operation, const char *path, AwaFloat value) {
+    return addAction(operation->response.actions, &operation->response.count, Action_SetValue, path, value);
+}
+
+/** Strings are not kept, the stored value is their length. */
+AwaError AwaClientSetOperation_AddValueAsCString(AwaClientSetOperation *operation, const char *path,
+                                                 const char *value) {
+    return addAction(operation->response.actions, &operation->response.count, Action_SetValue, path, strlen(value));
+}
+
+AwaError AwaClientSetOperation_AddValueAsInteger(AwaClientSetOperation *operation, const char *path,
+                                                 AwaInteger value) {
+    return addAction(operation->response.actions, &operation->response.count, Action_SetValue, path, value);
+}
+
+AwaError AwaClientSetOperation_Perform(AwaClientSetOperation *operation, AwaTimeout timeout) {
+    AwaError result;
+
+    (void)timeout;
+    if (operation == NULL) {
+        return AwaError_OperationInvalid;
+    }
+    simCount(SimCounter_SetOps);
+    result = performTransport(SimCounter_ClientOps);
+    return result != AwaError_Success ? result : performActions(operation->response.actions, operation->response.count);
+}
+
+const AwaClientSetResponse *AwaClientSetOperation_GetResponse(const AwaClientSetOperation *operation) {
+    return operation != NULL ? &operation->response : NULL;
+}
+
+const AwaPathResult *AwaClientSetResponse_GetPathResult(const AwaClientSetResponse *response, const char *path) {
+    const Action *action = findAction(response->actions, response->count, path);
+    return action != NULL ? &action->result : NULL;
+}
+
+AwaError AwaClientSetOperation_Free(AwaClientSetOperation **operation) {
+    if (operation == NULL || *operation == NULL) {
+        return AwaError_OperationInvalid;
+    }
+    free(*operation);
+    *operation = NULL;
+    return AwaError_Success;
+}
+
+AwaClientGetOperation *AwaClientGetOperation_New(const AwaClientSession *session) {
+    return session != NULL && session->connected ? calloc(1, sizeof(AwaClientGetOperation)) : NULL;
+}
+
+AwaError AwaClientGetOperation_AddPath(AwaClientGetOperation *operation, const char *path) {
+    return addAction(operation->response.actions, &operation->response.count, Action_GetValue, path, 0);
+}
+
+AwaError AwaClientGetOperation_Perform(AwaClientGetOperation *operation, AwaTimeout timeout) {
+    AwaError result;
+
+    (void)timeout;
+    if (operation == NULL) {
+        return AwaError_OperationInvalid;
+    }
+    simCount(SimCounter_GetOps);
+    result = performTransport(SimCounter_ClientOps);
+    return result != AwaError_Success ? result : performActions(operation->response.actions, operation->response.count);
+}
+
+const AwaClientGetResponse *AwaClientGetOperation_GetResponse(const AwaClientGetOperation *operation) {
+    return operation != NULL ? &operation->response : NULL;
+}
+
+AwaError AwaClientGetResponse_GetValueAsFloatPointer(const AwaClientGetResponse *response, const char *path,
+                                                     const AwaFloat **value) {
+    const Action *action = findAction(response->actions, response->count, path);
+    if (action == NULL) {
+        return AwaError_PathNotFound;
+    }
+    if (action->result.error == AwaError_Success) {
+        *value = &action->value;
+    }
+    return action->result.error;
+}
+
+AwaError AwaClientGetOperation_Free(AwaClientGetOperation **operation) {
+    if (operation == NULL || *operation == NULL) {
+        return AwaError_OperationInvalid;
+    }
+    free(*operation);
+    *operation = NULL;
+    return AwaError_Success;
+}
+
+/** True when the scenario describes resources of the client and it is registered with the server by now. */
+static bool clientKnown(const char *clientId) {
+    simLock();
+    bool known = simNodeRegistered(clientId);
+    simUnlock();
+    return known;
+}
+
+AwaServerSession *AwaServerSession_New(void) {
+    return calloc(1, sizeof(AwaServerSession));
+}
+
+AwaError AwaServerSession_Connect(AwaServerSession *session) {
+    AwaError result;
+
+    if (session == NULL) {
+        return AwaError_SessionInvalid;
+    }
+    result = performTransport(SimCounter_Connects);
+    session->connected = result == AwaError_Success;
+    return result;
+}
+
+AwaError AwaServerSession_Disconnect(AwaServerSession *session) {
+    if (session == NULL || !session->connected) {
+        return AwaError_SessionNotConnected;
+    }
+    session->connected = false;
+    return AwaError_Success;
+}
+
+AwaError AwaServerSession_Free(AwaServerSession **session) {
+    if (session == NULL || *session == NULL) {
+        return AwaError_SessionInvalid;
+    }
+    free(*session);
+    *session = NULL;
+    return AwaError_Success;
+}
+
+/** Waits for the next notification period and queues a change of every active observation. */
+AwaError AwaServerSession_Process(AwaServerSession *session, AwaTimeout timeout) {
+    int64_t now = simElapsedMs();
+    int i;
+
+    if (session == NULL || !session->connected) {
+        return AwaError_SessionNotConnected;
+    }
+    if (session->nextNotifyMs > now) {
+        long wait = session->nextNotifyMs - now;
+        simSleepMs(wait < timeout ? wait : timeout);
+        if (wait > timeout) {
+            return AwaError_Success;
+        }
+    }
+    session->nextNotifyMs = simElapsedMs() + FAKE_NOTIFY_PERIOD_MS;
+    if (simAwaOutage()) {
+        return AwaError_Success;
+    }
+
+    simLock();
+    const SimEvent *event;
+    while ((event = simEvent(session->nextEvent)) != NULL && event->atMs <= simElapsedMs()) {
+        session->nextEvent++;
+        if ((event->type == SimEvent_Register || event->type == SimEvent_Deregister) &&
+            session->pendingEventCount < FAKE_MAX_CLIENTS) {
+            session->pendingEvents[session->pendingEventCount++] = event;
+        }
+    }
+    for (i = 0; i < observationCount && session->pendingCount < FAKE_MAX_OBSERVATIONS; i++) {
+        AwaServerObservation *observation = observations[i];
+        SimNodeResource *resource;
+        int r;
+
+        for (r = 0; (resource = simNodeResource(r)) != NULL; r++) {
+            if (observation->active && strcmp(resource->clientId, observation->clientId) == 0 &&
+                strcmp(resource->path, observation->path) == 0) {
+                resource->value += resource->step;
+                snprintf(observation->changeSet.path, SIM_PATH_SIZE, "%s", resource->path);
+                observation->changeSet.value = resource->value;
+                session->pending[session->pendingCount++] = &observation->changeSet;
+            }
+        }
+    }
+    simUnlock();
+    return AwaError_Success;
+}
+
+AwaError AwaServerSession_DispatchCallbacks(AwaServerSession *session) {
+    int i;
+    int j;
+
+    if (session == NULL) {
+        return AwaError_SessionInvalid;
+    }
+    for (i = 0; i < session->pendingEventCount; i++) {
+        const SimEvent *event = session->pendingEvents[i];
+        if (event->type == SimEvent_Register && session->registerCallback != NULL) {
+            AwaServerClientRegisterEvent registerEvent = {{{{ 0 }}, 1 }};
+            snprintf(registerEvent.clients.clientIds[0], SIM_CLIENT_ID_SIZE, "%s", event->clientId);
+            session->registerCallback(&registerEvent, session->registerContext);
+        } else if (event->type == SimEvent_Deregister && session->deregisterCallback != NULL) {
+            AwaServerClientDeregisterEvent deregisterEvent = {{{{ 0 }}, 1 }};
+            snprintf(deregisterEvent.clients.clientIds[0], SIM_CLIENT_ID_SIZE, "%s", event->clientId);
+            session->deregisterCallback(&deregisterEvent, session->deregisterContext);
+        }
+    }
+    session->pendingEventCount = 0;
+
+    for (i = 0; i < session->pendingCount; i++) {
+        for (j = 0; j < observationCount; j++) {
+            if (&observations[j]->changeSet == session->pending[i] && observations[j]->active) {
+                simCount(SimCounter_Notifications);
+                observations[j]->callback(session->pending[i], observations[j]->context);
+            }
+        }
+    }
+    session->pendingCount = 0;
+    return AwaError_Success;
+}
+
+AwaError AwaServerSession_SetClientRegisterEventCallback(AwaServerSession *session,
+                                                        AwaServerClientRegisterEventCallback callback, void *context) {
+    if (session == NULL) {
+        return AwaError_SessionInvalid;
+    }
+    session->registerCallback = callback;
+    session->registerContext = context;
+    return AwaError_Success;
+}
+
+AwaError AwaServerSession_SetClientDeregisterEventCallback(AwaServerSession *session,
+                                                          AwaServerClientDeregisterEventCallback callback,
+                                                          void *context) {
+    if (session == NULL) {
+        return AwaError_SessionInvalid;
+    }
+    session->deregisterCallback = callback;
+    session->deregisterContext = context;
+    return AwaError_Success;
+}
+
+static AwaClientIterator *newIterator(const ClientList *list) {
+    AwaClientIterator *iterator = calloc(1, sizeof(AwaClientIterator));
+    if (iterator != NULL) {
+        iterator->list = *list;
+        iterator->position = -1;
+    }
+    return iterator;
+}
+
+AwaClientIterator *AwaServerClientRegisterEvent_NewClientIterator(const AwaServerClientRegisterEvent *event) {
+    return event != NULL ? newIterator(&event->clients) : NULL;
+}
+
+AwaClientIterator *AwaServerClientDeregisterEvent_NewClientIterator(const AwaServerClientDeregisterEvent *event) {
+    return event != NULL ? newIterator(&event->clients) : NULL;
+}
+
+bool AwaClientIterator_Next(AwaClientIterator *iterator) {
+    return iterator != NULL && ++iterator->position < iterator->list.count;
+}
+
+const char *AwaClientIterator_GetClientID(const AwaClientIterator *iterator) {
+    if (iterator == NULL || iterator->position < 0 || iterator->position >= iterator->list.count) {
+        return NULL;
+    }
+    return iterator->list.clientIds[iterator->position];
+}
+
+void AwaClientIterator_Free(AwaClientIterator **iterator) {
+    if (iterator != NULL) {
+        free(*iterator);
+        *iterator = NULL;
+    }
+}
+
+AwaServerListClientsOperation *AwaServerListClientsOperation_New(const AwaServerSession *session) {
+    return session != NULL && session->connected ? calloc(1, sizeof(AwaServerListClientsOperation)) : NULL;
+}
+
+/** Lists every client with resources which is registered by now. */
+AwaError AwaServerListClientsOperation_Perform(AwaServerListClientsOperation *operation, AwaTimeout timeout) {
+    ClientList *clients = &operation->clients;
+    SimNodeResource *resource;
+    AwaError result;
+    int r;
+    int i;
+
+    (void)timeout;
+    result = performTransport(SimCounter_ServerOps);
+    if (result != AwaError_Success) {
+        return result;
+    }
+
+    simLock();
+    clients->count = 0;
+    for (r = 0; (resource = simNodeResource(r)) != NULL; r++) {
+        bool listed = false;
+        for (i = 0; i < clients->count && !listed; i++) {
+            listed = strcmp(clients->clientIds[i], resource->clientId) == 0;
+        }
+        if (!listed && clients->count < FAKE_MAX_CLIENTS && simNodeRegistered(resource->clientId)) {
+            snprintf(clients->clientIds[clients->count++], SIM_CLIENT_ID_SIZE, "%s", resource->clientId);
+        }
+    }
+    simUnlock();
+    operation->performed = true;
+    return AwaError_Success;
+}
+
+AwaClientIterator *AwaServerListClientsOperation_NewClientIterator(const AwaServerListClientsOperation *operation) {
+    return operation != NULL && operation->performed ? newIterator(&operation->clients) : NULL;
+}
+
+AwaError AwaServerListClientsOperation_Free(AwaServerListClientsOperation **operation) {
+    if (operation == NULL || *operation == NULL) {
+        return AwaError_OperationInvalid;
+    }
+    free(*operation);
+    *operation = NULL;
+    return AwaError_Success;
+}
+
+AwaServerReadOperation *AwaServerReadOperation_New(const AwaServerSession *session) {
+    return session != NULL && session->connected ? calloc(1, sizeof(AwaServerReadOperation)) : NULL;
+}
+
+AwaError AwaServerReadOperation_AddPath(AwaServerReadOperation *operation, const char *clientID, const char *path) {
+    AwaServerReadResponse *response = &operation->response;
+
+    if (path == NULL || path[0] != '/') {
+        return AwaError_PathInvalid;
+    }
+    if (response->count == FAKE_MAX_ACTIONS) {
+        return AwaError_OutOfMemory;
+    }
+    snprintf(response->clientId, sizeof(response->clientId), "%s", clientID);
+    snprintf(response->paths[response->count++], SIM_PATH_SIZE, "%s", path);
+    return AwaError_Success;
+}
+
+AwaError AwaServerReadOperation_Perform(AwaServerReadOperation *operation, AwaTimeout timeout) {
+    AwaServerReadResponse *response = &operation->response;
+    int requested = response->count;
+    int found = 0;
+    int i;
+    int r;
+    SimNodeResource *resource;
+    AwaError result;
+
+    result = performTransport(SimCounter_ServerOps);
+    if (result != AwaError_Success) {
+        return result;
+    }
+    if (!clientKnown(response->clientId)) {
+        return AwaError_ClientNotFound;
+    }
+    long latency = simNodeLatencyMs(response->clientId);
+    if (latency > (long)timeout) {
+        simSleepMs(timeout);
+        simCount(SimCounter_NodeTimeouts);
+        return AwaError_Timeout;
+    }
+    simSleepMs(latency);
+
+    // requested paths are replaced by the resources found under them
+    simLock();
+    for (i = 0; i < requested; i++) {
+        for (r = 0; (resource = simNodeResource(r)) != NULL; r++) {
+            size_t length = strlen(response->paths[i]);
+            if (strcmp(resource->clientId, response->clientId) == 0 &&
+                strncmp(resource->path, response->paths[i], length) == 0 &&
+                (resource->path[length] == '/' || resource->path[length] == '\0') &&
+                requested + found < FAKE_MAX_ACTIONS) {
+                resource->value += resource->step;
+                snprintf(response->paths[requested + found], SIM_PATH_SIZE, "%s", resource->path);
+                response->values[requested + found] = resource->value;
+                found++;
+            }
+        }
+    }
+    simUnlock();
+
+    memmove(response->paths, response->paths + requested, sizeof(response->paths[0]) * found);
+    memmove(response->values, response->values + requested, sizeof(response->values[0]) * found);
+    response->count = found;
+    operation->performed = true;
+    return found > 0 ? AwaError_Success : AwaError_Response;
+}
+
+const AwaServerReadResponse *AwaServerReadOperation_GetResponse(const AwaServerReadOperation *operation,
+                                                                const char *clientID) {
+    if (operation == NULL || !operation->performed || strcmp(operation->response.clientId, clientID) != 0) {
+        return NULL;
+    }
+    return &operation->response;
+}
+
+AwaError AwaServerReadResponse_GetValueAsFloatPointer(const AwaServerReadResponse *response, const char *path,
+                                                      const AwaFloat **value) {
+    int i;
+    for (i = 0; i < response->count; i++) {
+        if (strcmp(response->paths[i], path) == 0) {
+            *value = &response->values[i];
+            return AwaError_Success;
+        }
+    }
+    return AwaError_PathNotFound;
+}
+
+AwaError AwaServerReadOperation_Free(AwaServerReadOperation **operation) {
+    if (operation == NULL || *operation == NULL) {
+        return AwaError_OperationInvalid;
+    }
+    free(*operation);
+    *operation = NULL;
+    return AwaError_Success;
+}
+
+AwaError AwaChangeSet_GetValueAsFloatPointer(const AwaChangeSet *changeSet, const char *path,
+                                             const AwaFloat **value) {
+    if (changeSet == NULL || strcmp(changeSet->path, path) != 0) {
+        return AwaError_PathNotFound;
+    }
+    *value = &changeSet->value;
+    return AwaError_Success;
+}
+
+AwaServerObservation *AwaServerObservation_New(const char *clientID, const char *path,
+                                               AwaServerObservationCallback callback, void *context) {
+    AwaServerObservation *observation = calloc(1, sizeof(AwaServerObservation));
+    if (observation != NULL) {
+        snprintf(observation->clientId, sizeof(observation->clientId), "%s", clientID);
+        snprintf(observation->path, sizeof(observation->path), "%s", path);
+        observation->callback = callback;
+        observation->context = context;
+    }
+    return observation;
+}
+
+AwaError AwaServerObservation_Free(AwaServerObservation **observation) {
+    int i;
+
+    if (observation == NULL || *observation == NULL) {
+        return AwaError_OperationInvalid;
+    }
+    simLock();
+    for (i = 0; i < observationCount; i++) {
+        if (observations[i] == *observation) {
+            observations[i] = observations[--observationCount];
+            break;
+        }
+    }
+    simUnlock();
+    free(*observation);
+    *observation = NULL;
+    return AwaError_Success;
+}
+
+AwaServerObserveOperation *AwaServerObserveOperation_New(const AwaServerSession *session) {
+    return session != NULL && session->connected ? calloc(1, sizeof(AwaServerObserveOperation)) : NULL;
+}
+
+static AwaError addObservation(AwaServerObserveOperation *operation, AwaServerObservation *observation, bool cancel) {
+    if (observation == NULL) {
+        return AwaError_OperationInvalid;
+    }
+    if (operation->count == FAKE_MAX_OBSERVATIONS) {
+        return AwaError_OutOfMemory;
+    }
+    operation->observations[operation->count] = observation;
+    operation->cancel[operation->count++] = cancel;
+    return AwaError_Success;
+}
+
+AwaError AwaServerObserveOperation_AddObservation(AwaServerObserveOperation *operation,
+                                                  AwaServerObservation *observation) {
+    return addObservation(operation, observation, false);
+}
+
+AwaError AwaServerObserveOperation_AddCancelObservation(AwaServerObserveOperation *operation,
+                                                        AwaServerObservation *observation) {
+    return addObservation(operation, observation, true);
+}
+
+AwaError AwaServerObserveOperation_Perform(AwaServerObserveOperation *operation, AwaTimeout timeout) {
+    AwaError result;
+    int i;
+    int j;
+
+    (void)timeout;
+    result = performTransport(SimCounter_ServerOps);
+    if (result != AwaError_Success) {
+        return result;
+    }
+
+    simLock();
+    for (i = 0; i < operation->count; i++) {
+        AwaServerObservation *observation = operation->observations[i];
+        bool registered = false;
+
+        if (!clientKnown(observation->clientId)) {
+            result = AwaError_Response;
+            continue;
+        }
+        observation->active = !operation->cancel[i];
+        for (j = 0; j < observationCount; j++) {
+            registered = registered || observations[j] == observation;
+        }
+        if (!registered && observationCount < FAKE_MAX_OBSERVATIONS) {
+            observations[observationCount++] = observation;
+        }
+    }
+    simUnlock();
+    return result;
+}
+
+AwaError AwaServerObserveOperation_Free(AwaServerObserveOperation **operation) {
+    if (operation == NULL || *operation == NULL) {
+        return AwaError_OperationInvalid;
+    }
+    free(*operation);
+    *operation = NULL;
+    return AwaError_Success;
+}
+
+AwaServerWriteAttributesOperation *AwaServerWriteAttributesOperation_New(const AwaServerSession *session) {
+    return session != NULL && session->connected ? calloc(1, sizeof(AwaServerWriteAttributesOperation)) : NULL;
+}
+
+static AwaError addAttribute(AwaServerWriteAttributesOperation *operation, const char *clientID) {
+    if (operation->count == FAKE_MAX_ACTIONS) {
+        return AwaError_OutOfMemory;
+    }
+    snprintf(operation->clientIds[operation->count++], SIM_CLIENT_ID_SIZE, "%s", clientID);
+    return AwaError_Success;
+}
+
+AwaError AwaServerWriteAttributesOperation_AddAttributeAsInteger(AwaServerWriteAttributesOperation *operation,
+        const char *clientID, const char *path, const char *link, AwaInteger value) {
+    (void)path;
+    (void)link;
+    (void)value;
+    return addAttribute(operation, clientID);
+}
+
+AwaError AwaServerWriteAttributesOperation_AddAttributeAsFloat(AwaServerWriteAttributesOperation *operation,
+        const char *clientID, const char *path, const char *link, AwaFloat value) {
+    (void)path;
+    (void)link;
+    (void)value;
+    return addAttribute(operation, clientID);
+}
+
+AwaError AwaServerWriteAttributesOperation_Perform(AwaServerWriteAttributesOperation *operation, AwaTimeout timeout) {
+    AwaError result;
+    int i;
+
+    (void)timeout;
+    result = performTransport(SimCounter_ServerOps);
+    for (i = 0; result == AwaError_Success && i < operation->count; i++) {
+        if (!clientKnown(operation->clientIds[i])) {
+            result = AwaError_Response;
+        }
+    }
+    return result;
+}
+
+AwaError AwaServerWriteAttributesOperation_Free(AwaServerWriteAttributesOperation **operation) {
+    if (operation == NULL || *operation == NULL) {
+        return AwaError_OperationInvalid;
+    }
+    free(*operation);
+    *operation = NULL;
+    return AwaError_Success;
+}
@@ -0,0 +1,384 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * Stand-in for the LetMeCreate click drivers. Values come from the scenario series, reads can be delayed and failed,
+ * and I2C reads of a bus selected by another thread are counted as violations of the bus locking. The SPI bus holds
+ * registers of an AS3935 (Thunder click) which raises the scripted events on its IRQ line. The Weather click keeps
+ * BME280 control registers per bus, conversions take their typical time and reads in forced mode need a fresh one.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+#include <letmecreate/letmecreate.h>
+#include "simControl.h"
+
+static pthread_t busOwner;
+static bool busSelected = false;
+static uint8_t selectedBus = MIKROBUS_1;
+static unsigned long i2cReads = 0;
+
+//! \{
+#define AS3935_REGISTERS        (0x40)
+#define AS3935_INTERRUPT        (0x03)
+#define AS3935_MASK_DISTURBER   (0x20)
+//! \}
+
+//! \{
+#define BME280_STATUS           (0xF3)
+#define BME280_CTRL_MEAS        (0xF4)
+#define BME280_CTRL_HUM         (0xF2)
+#define BME280_CONFIG           (0xF5)
+#define BME280_MODE(ctrlMeas)   ((ctrlMeas) & 0x03)
+#define BME280_MODE_FORCED      (0x01)
+//! \}
+
+typedef struct {
+    uint8_t ctrlHum;
+    uint8_t ctrlMeas;
+    uint8_t config;
+    int64_t conversionEnd;  /**< simElapsedMs() the running forced conversion finishes at */
+    bool fresh;             /**< finished conversion not read yet */
+} FakeBme280;
+
+static FakeBme280 bme280[MIKROBUS_COUNT];
+
+static uint8_t as3935[AS3935_REGISTERS];
+static void (*irqCallback)(uint8_t) = NULL;
+static pthread_t irqThread;
+static volatile bool irqRunning = false;
+
+/** Defaults after power up or PRESET_DEFAULT command. */
+static void as3935Reset(void) {
+    memset(as3935, 0, sizeof(as3935));
+    as3935[0x00] = 0x24;
+    as3935[0x01] = 0x22;
+    as3935[0x02] = 0xC2;
+    as3935[0x07] = 0x3F;
+}
+
+static void *raiseEvents(void *context) {
+    const SimEvent *event;
+    int index;
+
+    (void)context;
+    for (index = 0; irqRunning && (event = simEvent(index)) != NULL; index++) {
+        long wait = event->atMs - simElapsedMs();
+        simSleepMs(wait > 0 ? wait : 0);
+
+        simLock();
+        uint8_t interrupt = 0;
+        switch (event->type) {
+            case SimEvent_Lightning:
+                interrupt = 0x08;
+                as3935[0x04] = event->energy & 0xFF;
+                as3935[0x05] = (event->energy >> 8) & 0xFF;
+                as3935[0x06] = (event->energy >> 16) & 0x1F;
+                as3935[0x07] = event->distance & 0x3F;
+                break;
+            case SimEvent_Disturber:
+                interrupt = as3935[AS3935_INTERRUPT] & AS3935_MASK_DISTURBER ? 0 : 0x04;
+                break;
+            case SimEvent_Noise:
+                interrupt = 0x01;
+                break;
+            default:
+                simUnlock();
+                continue;
+        }
+        as3935[AS3935_INTERRUPT] = (as3935[AS3935_INTERRUPT] & 0xF0) | interrupt;
+        simUnlock();
+
+        if (interrupt != 0 && irqRunning) {
+            simCount(SimCounter_Interrupts);
+            irqCallback(GPIO_RISING);
+        }
+    }
+    return NULL;
+}
+
+int gpio_monitor_init(void) {
+    return 0;
+}
+
+int gpio_monitor_add_callback(uint8_t gpio_pin, uint8_t event_mask, void (*callback)(uint8_t)) {
+    (void)gpio_pin;
+    (void)event_mask;
+    if (irqCallback != NULL) {
+        return -1;
+    }
+    irqCallback = callback;
+    irqRunning = true;
+    pthread_create(&irqThread, NULL, raiseEvents, NULL);
+    pthread_detach(irqThread);
+    return 0;
+}
+
+int gpio_monitor_remove_callback(int callback_ID) {
+    (void)callback_ID;
+    irqRunning = false;
+    return 0;
+}
+
+int gpio_monitor_release(void) {
+    return 0;
+}
+
+int spi_init(void) {
+    as3935Reset();
+    return 0;
+}
+
+int spi_select_bus(uint8_t mikrobus_index) {
+    return mikrobus_index < MIKROBUS_COUNT ? 0 : -1;
+}
+
+/** Two byte AS3935 frames: mode and address, then data. Reading the interrupt register clears it. */
+int spi_transfer(const uint8_t *tx_buffer, uint8_t *rx_buffer, uint32_t count) {
+    uint8_t address = tx_buffer[0] & 0x3F;
+
+    if (count != 2) {
+        return -1;
+    }
+    simCount(SimCounter_SpiTransfers);
+    simLock();
+    if (tx_buffer[0] & 0x40) {
+        rx_buffer[1] = as3935[address];
+        if (address == AS3935_INTERRUPT) {
+            as3935[AS3935_INTERRUPT] &= 0xF0;
+        }
+    } else if (address == 0x3C) {
+        as3935Reset();
+    } else if (address == AS3935_INTERRUPT) {
+        as3935[address] = (tx_buffer[1] & 0xF0) | (as3935[address] & 0x0F);
+    } else if (address < AS3935_REGISTERS) {
+        as3935[address] = tx_buffer[1];
+    }
+    simUnlock();
+    return 0;
+}
+
+int spi_release(void) {
+    return 0;
+}
+
+int i2c_init(void) {
+    return 0;
+}
+
+int i2c_select_bus(uint8_t mikrobus_index) {
+    if (mikrobus_index >= MIKROBUS_COUNT) {
+        return -1;
+    }
+    simLock();
+    busOwner = pthread_self();
+    busSelected = true;
+    selectedBus = mikrobus_index;
+    simUnlock();
+    return 0;
+}
+
+int i2c_release(void) {
+    simLock();
+    busSelected = false;
+    simUnlock();
+    return 0;
+}
+
+static int oversampling(uint8_t code) {
+    return code == 0 ? 0 : 1 << ((code > 5 ? 5 : code) - 1);
+}
+
+/** Typical conversion time from the datasheet. */
+static long conversionMs(const FakeBme280 *sensor) {
+    int temperature = oversampling(sensor->ctrlMeas >> 5);
+    int pressure = oversampling((sensor->ctrlMeas >> 2) & 0x07);
+    int humidity = oversampling(sensor->ctrlHum & 0x07);
+
+    return (long)ceil(1 + 2 * temperature + (pressure > 0 ? 2 * pressure + 0.5 : 0) +
+                      (humidity > 0 ? 2 * humidity + 0.5 : 0));
+}
+
+/** Forced conversion finished, the sensor is back in sleep mode. */
+static void bme280Update(FakeBme280 *sensor) {
+    if (BME280_MODE(sensor->ctrlMeas) == BME280_MODE_FORCED && simElapsedMs() >= sensor->conversionEnd) {
+        sensor->ctrlMeas &= ~0x03;
+    }
+}
+
+int i2c_write_register(uint16_t address, uint8_t reg_address, uint8_t data) {
+    (void)address;
+    simLock();
+    FakeBme280 *sensor = &bme280[selectedBus];
+    switch (reg_address) {
+        case BME280_CTRL_HUM:
+            sensor->ctrlHum = data;
+            break;
+        case BME280_CONFIG:
+            sensor->config = data;
+            break;
+        case BME280_CTRL_MEAS:
+            sensor->ctrlMeas = data;
+            if (BME280_MODE(data) == BME280_MODE_FORCED) {
+                sensor->conversionEnd = simElapsedMs() + conversionMs(sensor);
+                sensor->fresh = true;
+                simCount(SimCounter_Conversions);
+            }
+            break;
+    }
+    simUnlock();
+    return 0;
+}
+
+int i2c_read_register(uint16_t address, uint8_t reg_address, uint8_t *data) {
+    (void)address;
+    simLock();
+    FakeBme280 *sensor = &bme280[selectedBus];
+    bme280Update(sensor);
+    switch (reg_address) {
+        case BME280_STATUS:
+            *data = BME280_MODE(sensor->ctrlMeas) == BME280_MODE_FORCED ? 0x08 : 0x00;
+            break;
+        case BME280_CTRL_MEAS:
+            *data = sensor->ctrlMeas;
+            break;
+        case BME280_CTRL_HUM:
+            *data = sensor->ctrlHum;
+            break;
+        case BME280_CONFIG:
+            *data = sensor->config;
+            break;
+        default:
+            *data = 0;
+    }
+    simUnlock();
+    return 0;
+}
+
+/** Scripted fault of the click, a hung one blocks the caller until the fault ends. Returns false to fail the read. */
+static bool clickResponds(uint8_t bus) {
+    long remainingMs = 0;
+    SimFault fault = simSensorFault(bus, &remainingMs);
+
+    if (fault == SimFault_Hang) {
+        simSleepMs(remainingMs);
+    }
+    return fault != SimFault_Fail;
+}
+
+/** Common part of I2C transfers, returns false when the read is to fail. */
+static bool i2cTransfer(void) {
+    bool owned;
+    bool fail;
+    uint8_t bus;
+
+    simSleepMs(g_SimConfig.i2cLatencyMs);
+    simLock();
+    owned = busSelected && pthread_equal(busOwner, pthread_self());
+    fail = g_SimConfig.i2cFailEvery > 0 && ++i2cReads % g_SimConfig.i2cFailEvery == 0;
+    bus = selectedBus;
+    simUnlock();
+    fail = !clickResponds(bus) || fail;
+
+    simCount(SimCounter_SensorReads);
+    if (!owned) {
+        simCount(SimCounter_I2CViolations);
+    }
+    if (fail) {
+        simCount(SimCounter_SensorFailures);
+    }
+    return !fail;
+}
+
+int thermo3_click_enable(uint8_t add_bit) {
+    (void)add_bit;
+    return 0;
+}
+
+int thermo3_click_get_temperature(float *temperature) {
+    if (!i2cTransfer()) {
+        return -1;
+    }
+    *temperature = simNextValue("thermo3", 20.0);
+    return 0;
+}
+
+int thermo3_click_disable(void) {
+    return 0;
+}
+
+int weather_click_enable(void) {
+    simLock();
+    memset(&bme280[selectedBus], 0, sizeof(bme280[selectedBus]));
+    simUnlock();
+    return 0;
+}
+
+/** Skipped channels read as 0. */
+int weather_click_read_measurements(double *temperature, double *pressure, double *humidity) {
+    if (!i2cTransfer()) {
+        return -1;
+    }
+
+    simLock();
+    FakeBme280 *sensor = &bme280[selectedBus];
+    bme280Update(sensor);
+    // sleep mode after a configuration only holds results of the last forced conversion
+    if (sensor->ctrlMeas != 0 && BME280_MODE(sensor->ctrlMeas) != 0x03 &&
+        (!sensor->fresh || BME280_MODE(sensor->ctrlMeas) == BME280_MODE_FORCED)) {
+        simCount(SimCounter_StaleReads);
+    }
+    sensor->fresh = false;
+    bool legacy = sensor->ctrlMeas == 0;
+    bool pressureSkipped = !legacy && ((sensor->ctrlMeas >> 2) & 0x07) == 0;
+    bool humiditySkipped = !legacy && (sensor->ctrlHum & 0x07) == 0;
+    simUnlock();
+
+    *temperature = simNextValue("temperature", 20.0);
+    *pressure = pressureSkipped ? 0 : simNextValue("pressure", 101325.0);
+    *humidity = humiditySkipped ? 0 : simNextValue("humidity", 50.0);
+    return 0;
+}
+
+int weather_click_disable(void) {
+    return 0;
+}
+
+int co_click_get_measure(uint8_t mikrobus_index, uint16_t *measure) {
+    simCount(SimCounter_SensorReads);
+    if (!clickResponds(mikrobus_index)) {
+        simCount(SimCounter_SensorFailures);
+        return -1;
+    }
+    *measure = (uint16_t)simNextValue("co", 100.0);
+    return 0;
+}
+
+int air_quality_click_get_measure(uint8_t mikrobus_index, uint16_t *measure) {
+    simCount(SimCounter_SensorReads);
+    if (!clickResponds(mikrobus_index)) {
+        simCount(SimCounter_SensorFailures);
+        return -1;
+    }
+    *measure = (uint16_t)simNextValue("air", 200.0);
+    return 0;
+}
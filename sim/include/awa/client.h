@@ -0,0 +1,71 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file client.h
+ * @brief Stand-in for the Awa LwM2M client API, subset used by the weather station. See sim/fakeAwa.c.
+ */
+
+#ifndef AWA_CLIENT_H
+#define AWA_CLIENT_H
+
+#include "types.h"
+
+typedef struct _AwaClientSession AwaClientSession;
+typedef struct _AwaClientSetOperation AwaClientSetOperation;
+typedef struct _AwaClientSetResponse AwaClientSetResponse;
+typedef struct _AwaClientGetOperation AwaClientGetOperation;
+typedef struct _AwaClientGetResponse AwaClientGetResponse;
+typedef struct _AwaClientDefineOperation AwaClientDefineOperation;
+
+AwaClientSession * AwaClientSession_New(void);
+AwaError AwaClientSession_SetIPCAsUDP(AwaClientSession * session, const char * address, unsigned short port);
+AwaError AwaClientSession_Connect(AwaClientSession * session);
+AwaError AwaClientSession_Disconnect(AwaClientSession * session);
+AwaError AwaClientSession_Free(AwaClientSession ** session);
+bool AwaClientSession_IsObjectDefined(const AwaClientSession * session, AwaObjectID objectID);
+
+AwaClientDefineOperation * AwaClientDefineOperation_New(const AwaClientSession * session);
+AwaError AwaClientDefineOperation_Add(AwaClientDefineOperation * operation, const AwaObjectDefinition * objectDefinition);
+AwaError AwaClientDefineOperation_Perform(AwaClientDefineOperation * operation, AwaTimeout timeout);
+AwaError AwaClientDefineOperation_Free(AwaClientDefineOperation ** operation);
+
+AwaClientSetOperation * AwaClientSetOperation_New(const AwaClientSession * session);
+AwaError AwaClientSetOperation_CreateObjectInstance(AwaClientSetOperation * operation, const char * path);
+AwaError AwaClientSetOperation_CreateOptionalResource(AwaClientSetOperation * operation, const char * path);
+AwaError AwaClientSetOperation_AddValueAsFloat(AwaClientSetOperation * operation, const char * path, AwaFloat value);
+AwaError AwaClientSetOperation_AddValueAsCString(AwaClientSetOperation * operation, const char * path,
+                                                 const char * value);
+AwaError AwaClientSetOperation_AddValueAsInteger(AwaClientSetOperation * operation, const char * path,
+                                                 AwaInteger value);
+AwaError AwaClientSetOperation_Perform(AwaClientSetOperation * operation, AwaTimeout timeout);
+const AwaClientSetResponse * AwaClientSetOperation_GetResponse(const AwaClientSetOperation * operation);
+const AwaPathResult * AwaClientSetResponse_GetPathResult(const AwaClientSetResponse * response, const char * path);
+AwaError AwaClientSetOperation_Free(AwaClientSetOperation ** operation);
+
+AwaClientGetOperation * AwaClientGetOperation_New(const AwaClientSession * session);
+AwaError AwaClientGetOperation_AddPath(AwaClientGetOperation * operation, const char * path);
+AwaError AwaClientGetOperation_Perform(AwaClientGetOperation * operation, AwaTimeout timeout);
+const AwaClientGetResponse * AwaClientGetOperation_GetResponse(const AwaClientGetOperation * operation);
+AwaError AwaClientGetResponse_GetValueAsFloatPointer(const AwaClientGetResponse * response, const char * path,
+                                                     const AwaFloat ** value);
+AwaError AwaClientGetOperation_Free(AwaClientGetOperation ** operation);
+
+#endif  /* AWA_CLIENT_H */
@@ -0,0 +1,54 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file common.h
+ * @brief Stand-in for the Awa LwM2M API, subset used by the weather station. See sim/fakeAwa.c.
+ */
+
+#ifndef AWA_COMMON_H
+#define AWA_COMMON_H
+
+#include "types.h"
+
+typedef struct _AwaObjectDefinition AwaObjectDefinition;
+
+AwaError AwaPathResult_GetError(const AwaPathResult * result);
+
+AwaObjectDefinition * AwaObjectDefinition_New(AwaObjectID objectID, const char * objectName, int minimumInstances,
+                                              int maximumInstances);
+void AwaObjectDefinition_Free(AwaObjectDefinition ** objectDefinition);
+AwaError AwaObjectDefinition_AddResourceDefinitionAsString(AwaObjectDefinition * objectDefinition,
+                                                           AwaResourceID resourceID, const char * resourceName,
+                                                           bool isMandatory, AwaResourceOperations operations,
+                                                           const char * defaultValue);
+AwaError AwaObjectDefinition_AddResourceDefinitionAsInteger(AwaObjectDefinition * objectDefinition,
+                                                            AwaResourceID resourceID, const char * resourceName,
+                                                            bool isMandatory, AwaResourceOperations operations,
+                                                            AwaInteger defaultValue);
+AwaError AwaObjectDefinition_AddResourceDefinitionAsFloat(AwaObjectDefinition * objectDefinition,
+                                                          AwaResourceID resourceID, const char * resourceName,
+                                                          bool isMandatory, AwaResourceOperations operations,
+                                                          AwaFloat defaultValue);
+
+AwaError AwaChangeSet_GetValueAsFloatPointer(const AwaChangeSet * changeSet, const char * path,
+                                             const AwaFloat ** value);
+
+#endif  /* AWA_COMMON_H */
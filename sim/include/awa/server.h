@@ -0,0 +1,97 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file server.h
+ * @brief Stand-in for the Awa LwM2M server API, subset used by the weather station. See sim/fakeAwa.c.
+ */
+
+#ifndef AWA_SERVER_H
+#define AWA_SERVER_H
+
+#include "types.h"
+
+typedef struct _AwaServerSession AwaServerSession;
+typedef struct _AwaServerReadOperation AwaServerReadOperation;
+typedef struct _AwaServerReadResponse AwaServerReadResponse;
+typedef struct _AwaServerObserveOperation AwaServerObserveOperation;
+typedef struct _AwaServerObservation AwaServerObservation;
+typedef struct _AwaServerWriteAttributesOperation AwaServerWriteAttributesOperation;
+typedef struct _AwaServerListClientsOperation AwaServerListClientsOperation;
+typedef struct _AwaClientIterator AwaClientIterator;
+typedef struct _AwaServerClientRegisterEvent AwaServerClientRegisterEvent;
+typedef struct _AwaServerClientDeregisterEvent AwaServerClientDeregisterEvent;
+
+typedef void (*AwaServerObservationCallback)(const AwaChangeSet * changeSet, void * context);
+typedef void (*AwaServerClientRegisterEventCallback)(const AwaServerClientRegisterEvent * event, void * context);
+typedef void (*AwaServerClientDeregisterEventCallback)(const AwaServerClientDeregisterEvent * event, void * context);
+
+AwaServerSession * AwaServerSession_New(void);
+AwaError AwaServerSession_Connect(AwaServerSession * session);
+AwaError AwaServerSession_Disconnect(AwaServerSession * session);
+AwaError AwaServerSession_Free(AwaServerSession ** session);
+AwaError AwaServerSession_Process(AwaServerSession * session, AwaTimeout timeout);
+AwaError AwaServerSession_DispatchCallbacks(AwaServerSession * session);
+AwaError AwaServerSession_SetClientRegisterEventCallback(AwaServerSession * session,
+                                                         AwaServerClientRegisterEventCallback callback, void * context);
+AwaError AwaServerSession_SetClientDeregisterEventCallback(AwaServerSession * session,
+                                                           AwaServerClientDeregisterEventCallback callback,
+                                                           void * context);
+
+AwaClientIterator * AwaServerClientRegisterEvent_NewClientIterator(const AwaServerClientRegisterEvent * event);
+AwaClientIterator * AwaServerClientDeregisterEvent_NewClientIterator(const AwaServerClientDeregisterEvent * event);
+bool AwaClientIterator_Next(AwaClientIterator * iterator);
+const char * AwaClientIterator_GetClientID(const AwaClientIterator * iterator);
+void AwaClientIterator_Free(AwaClientIterator ** iterator);
+
+AwaServerListClientsOperation * AwaServerListClientsOperation_New(const AwaServerSession * session);
+AwaError AwaServerListClientsOperation_Perform(AwaServerListClientsOperation * operation, AwaTimeout timeout);
+AwaClientIterator * AwaServerListClientsOperation_NewClientIterator(const AwaServerListClientsOperation * operation);
+AwaError AwaServerListClientsOperation_Free(AwaServerListClientsOperation ** operation);
+
+AwaServerReadOperation * AwaServerReadOperation_New(const AwaServerSession * session);
+AwaError AwaServerReadOperation_AddPath(AwaServerReadOperation * operation, const char * clientID, const char * path);
+AwaError AwaServerReadOperation_Perform(AwaServerReadOperation * operation, AwaTimeout timeout);
+const AwaServerReadResponse * AwaServerReadOperation_GetResponse(const AwaServerReadOperation * operation,
+                                                                 const char * clientID);
+AwaError AwaServerReadResponse_GetValueAsFloatPointer(const AwaServerReadResponse * response, const char * path,
+                                                      const AwaFloat ** value);
+AwaError AwaServerReadOperation_Free(AwaServerReadOperation ** operation);
+
+AwaServerObservation * AwaServerObservation_New(const char * clientID, const char * path,
+                                                AwaServerObservationCallback callback, void * context);
+AwaError AwaServerObservation_Free(AwaServerObservation ** observation);
+AwaServerObserveOperation * AwaServerObserveOperation_New(const AwaServerSession * session);
+AwaError AwaServerObserveOperation_AddObservation(AwaServerObserveOperation * operation,
+                                                  AwaServerObservation * observation);
+AwaError AwaServerObserveOperation_AddCancelObservation(AwaServerObserveOperation * operation,
+                                                        AwaServerObservation * observation);
+AwaError AwaServerObserveOperation_Perform(AwaServerObserveOperation * operation, AwaTimeout timeout);
+AwaError AwaServerObserveOperation_Free(AwaServerObserveOperation ** operation);
+
+AwaServerWriteAttributesOperation * AwaServerWriteAttributesOperation_New(const AwaServerSession * session);
+AwaError AwaServerWriteAttributesOperation_AddAttributeAsInteger(AwaServerWriteAttributesOperation * operation,
+        const char * clientID, const char * path, const char * link, AwaInteger value);
+AwaError AwaServerWriteAttributesOperation_AddAttributeAsFloat(AwaServerWriteAttributesOperation * operation,
+        const char * clientID, const char * path, const char * link, AwaFloat value);
+AwaError AwaServerWriteAttributesOperation_Perform(AwaServerWriteAttributesOperation * operation, AwaTimeout timeout);
+AwaError AwaServerWriteAttributesOperation_Free(AwaServerWriteAttributesOperation ** operation);
+
+#endif  /* AWA_SERVER_H */
@@ -0,0 +1,76 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file types.h
+ * @brief Stand-in for the Awa LwM2M API, subset used by the weather station. See sim/fakeAwa.c.
+ */
+
+#ifndef AWA_TYPES_H
+#define AWA_TYPES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int AwaObjectID;
+typedef int AwaResourceID;
+typedef int AwaObjectInstanceID;
+typedef int32_t AwaTimeout;
+typedef double AwaFloat;
+typedef int64_t AwaInteger;
+
+#define AWA_MAX_ID (65535)
+
+typedef enum {
+    AwaError_Success = 0,
+    AwaError_Unspecified,
+    AwaError_Unsupported,
+    AwaError_Internal,
+    AwaError_OutOfMemory,
+    AwaError_IPCError,
+    AwaError_Timeout,
+    AwaError_SessionInvalid,
+    AwaError_SessionNotConnected,
+    AwaError_NotDefined,
+    AwaError_AlreadyDefined,
+    AwaError_OperationInvalid,
+    AwaError_PathInvalid,
+    AwaError_PathNotFound,
+    AwaError_TypeMismatch,
+    AwaError_Response,
+    AwaError_CannotCreate,
+    AwaError_LWM2MError,
+    AwaError_ClientNotFound,
+    AwaError_LAST
+} AwaError;
+
+typedef enum {
+    AwaResourceOperations_None,
+    AwaResourceOperations_ReadOnly,
+    AwaResourceOperations_WriteOnly,
+    AwaResourceOperations_ReadWrite,
+    AwaResourceOperations_Execute
+} AwaResourceOperations;
+
+typedef struct _AwaPathResult AwaPathResult;
+typedef struct _AwaChangeSet AwaChangeSet;
+
+#endif  /* AWA_TYPES_H */
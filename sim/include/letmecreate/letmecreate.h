@@ -0,0 +1,73 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file letmecreate.h
+ * @brief Stand-in for the LetMeCreate library, subset used by the weather station. See sim/fakeLetMeCreate.c.
+ */
+
+#ifndef LETMECREATE_H
+#define LETMECREATE_H
+
+#include <stdint.h>
+
+enum MIKROBUS_INDEX {
+    MIKROBUS_1,
+    MIKROBUS_2,
+    MIKROBUS_COUNT
+};
+
+enum GPIO_PIN {
+    MIKROBUS_1_INT = 21,
+    MIKROBUS_2_INT = 24
+};
+
+#define GPIO_RISING     (0x01)
+#define GPIO_FALLING    (0x02)
+#define GPIO_EDGE       (GPIO_RISING | GPIO_FALLING)
+
+int gpio_monitor_init(void);
+int gpio_monitor_add_callback(uint8_t gpio_pin, uint8_t event_mask, void (*callback)(uint8_t));
+int gpio_monitor_remove_callback(int callback_ID);
+int gpio_monitor_release(void);
+
+int spi_init(void);
+int spi_select_bus(uint8_t mikrobus_index);
+int spi_transfer(const uint8_t *tx_buffer, uint8_t *rx_buffer, uint32_t count);
+int spi_release(void);
+
+int i2c_init(void);
+int i2c_select_bus(uint8_t mikrobus_index);
+int i2c_write_register(uint16_t address, uint8_t reg_address, uint8_t data);
+int i2c_read_register(uint16_t address, uint8_t reg_address, uint8_t *data);
+int i2c_release(void);
+
+int thermo3_click_enable(uint8_t add_bit);
+int thermo3_click_get_temperature(float *temperature);
+int thermo3_click_disable(void);
+
+int weather_click_enable(void);
+int weather_click_read_measurements(double *temperature, double *pressure, double *humidity);
+int weather_click_disable(void);
+
+int co_click_get_measure(uint8_t mikrobus_index, uint16_t *measure);
+int air_quality_click_get_measure(uint8_t mikrobus_index, uint16_t *measure);
+
+#endif  /* LETMECREATE_H */
@@ -0,0 +1,461 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "simControl.h"
+
+//! \{
+#define SIM_SCRIPT_ENV          "WS_SIM_SCRIPT"
+#define SIM_MAX_SERIES          (8)
+#define SIM_MAX_SERIES_VALUES   (32)
+#define SIM_MAX_NODE_RESOURCES  (64)
+#define SIM_MAX_NODE_LATENCIES  (16)
+#define SIM_MAX_SENSOR_FAULTS   (8)
+#define SIM_MAX_EXPECTATIONS    (32)
+#define SIM_MAX_EVENTS          (64)
+#define SIM_LINE_SIZE           (256)
+//! \}
+
+typedef struct {
+    char name[16];
+    double values[SIM_MAX_SERIES_VALUES];
+    int count;
+    int next;
+} Series;
+
+typedef struct {
+    char subject[SIM_PATH_SIZE];
+    char op[3];
+    double value;
+    char reference[SIM_PATH_SIZE];   /**< subject value is added to, empty when value is a constant */
+    int line;
+} Expectation;
+
+static const char *counterNames[SimCounter_Count] = {
+    "client_ops", "set_ops", "get_ops", "server_ops", "connects", "failed_ops", "sensor_reads", "sensor_failures",
+    "i2c_violations", "notifications", "interrupts", "spi_transfers",
+    "conversions", "stale_reads", "node_timeouts", "define_ops", "sensor_values"
+};
+
+SimConfig g_SimConfig = { 0 };
+
+static pthread_mutex_t lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static unsigned long counters[SimCounter_Count];
+static struct timespec startTime;
+static long runMs = -1;
+static Series series[SIM_MAX_SERIES];
+static int seriesCount = 0;
+static SimNodeResource nodeResources[SIM_MAX_NODE_RESOURCES];
+static int nodeResourceCount = 0;
+static struct {
+    char clientId[SIM_CLIENT_ID_SIZE];
+    long latencyMs;
+    long fromMs;
+} nodeLatencies[SIM_MAX_NODE_LATENCIES];
+static int nodeLatencyCount = 0;
+static struct {
+    int bus;
+    long startMs;
+    long durationMs;
+    SimFault fault;
+} sensorFaults[SIM_MAX_SENSOR_FAULTS];
+static int sensorFaultCount = 0;
+static SimEvent events[SIM_MAX_EVENTS];
+static int eventCount = 0;
+static Expectation expectations[SIM_MAX_EXPECTATIONS];
+static int expectationCount = 0;
+
+void simLock(void) {
+    pthread_mutex_lock(&lock);
+}
+
+void simUnlock(void) {
+    pthread_mutex_unlock(&lock);
+}
+
+void simCount(SimCounter counter) {
+    simLock();
+    counters[counter]++;
+    simUnlock();
+}
+
+int64_t simElapsedMs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)(now.tv_sec - startTime.tv_sec) * 1000 + (now.tv_nsec - startTime.tv_nsec) / 1000000;
+}
+
+void simSleepMs(long ms) {
+    struct timespec delay = { ms / 1000, (ms % 1000) * 1000000L };
+    while (ms > 0 && nanosleep(&delay, &delay) != 0 && errno == EINTR);
+}
+
+bool simAwaOutage(void) {
+    int64_t now = simElapsedMs();
+    return g_SimConfig.awaOutageDurationMs > 0 && now >= g_SimConfig.awaOutageStartMs &&
+        now < g_SimConfig.awaOutageStartMs + g_SimConfig.awaOutageDurationMs;
+}
+
+double simNextValue(const char *name, double fallback) {
+    double value = fallback;
+    int i;
+
+    simLock();
+    for (i = 0; i < seriesCount; i++) {
+        if (strcmp(series[i].name, name) == 0) {
+            value = series[i].values[series[i].next];
+            series[i].next = (series[i].next + 1) % series[i].count;
+            break;
+        }
+    }
+    simUnlock();
+    return value;
+}
+
+SimNodeResource *simNodeResource(int index) {
+    return index < nodeResourceCount ? &nodeResources[index] : NULL;
+}
+
+const SimEvent *simEvent(int index) {
+    return index < eventCount ? &events[index] : NULL;
+}
+
+bool simNodeRegistered(const char *clientId) {
+    int64_t now = simElapsedMs();
+    bool known = false;
+    bool registered = true;
+    bool first = true;
+    int i;
+
+    for (i = 0; i < nodeResourceCount && !known; i++) {
+        known = strcmp(nodeResources[i].clientId, clientId) == 0;
+    }
+    for (i = 0; i < eventCount; i++) {
+        if ((events[i].type != SimEvent_Register && events[i].type != SimEvent_Deregister) ||
+            strcmp(events[i].clientId, clientId) != 0) {
+            continue;
+        }
+        if (first) {
+            registered = events[i].type != SimEvent_Register;
+            first = false;
+        }
+        if (events[i].atMs <= now) {
+            registered = events[i].type == SimEvent_Register;
+        }
+    }
+    return known && registered;
+}
+
+long simNodeLatencyMs(const char *clientId) {
+    int64_t now = simElapsedMs();
+    long latencyMs = 0;
+    int i;
+
+    // the last line in effect by now wins
+    for (i = 0; i < nodeLatencyCount; i++) {
+        if (strcmp(nodeLatencies[i].clientId, clientId) == 0 && nodeLatencies[i].fromMs <= now) {
+            latencyMs = nodeLatencies[i].latencyMs;
+        }
+    }
+    return latencyMs;
+}
+
+SimFault simSensorFault(int bus, long *remainingMs) {
+    int64_t now = simElapsedMs();
+    int i;
+
+    for (i = 0; i < sensorFaultCount; i++) {
+        if (sensorFaults[i].bus == bus && now >= sensorFaults[i].startMs &&
+            now < sensorFaults[i].startMs + sensorFaults[i].durationMs) {
+            *remainingMs = sensorFaults[i].startMs + sensorFaults[i].durationMs - now;
+            return sensorFaults[i].fault;
+        }
+    }
+    return SimFault_None;
+}
+
+
+static void scriptError(const char *script, int line, const char *message) {
+    fprintf(stderr, "%s:%d: %s\n", script, line, message);
+    exit(2);
+}
+
+static void addEvent(const char *script, int line, long atMs, const char *type) {
+    SimEvent *event;
+    int index;
+
+    if (eventCount == SIM_MAX_EVENTS) {
+        scriptError(script, line, "too many events");
+    }
+    // keep events sorted by time
+    for (index = eventCount; index > 0 && events[index - 1].atMs > atMs; index--) {
+        events[index] = events[index - 1];
+    }
+    event = &events[index];
+    eventCount++;
+    memset(event, 0, sizeof(*event));
+    event->atMs = atMs;
+    if (strcmp(type, "lightning") == 0) {
+        char *distance = strtok(NULL, " \t\r\n");
+        char *energy = strtok(NULL, " \t\r\n");
+        if (energy == NULL) {
+            scriptError(script, line, "lightning needs distance and energy");
+        }
+        event->type = SimEvent_Lightning;
+        event->distance = atoi(distance);
+        event->energy = strtoul(energy, NULL, 10);
+    } else if (strcmp(type, "disturber") == 0) {
+        event->type = SimEvent_Disturber;
+    } else if (strcmp(type, "noise") == 0) {
+        event->type = SimEvent_Noise;
+    } else if (strcmp(type, "register") == 0 || strcmp(type, "deregister") == 0) {
+        char *clientId = strtok(NULL, " \t\r\n");
+        if (clientId == NULL) {
+            scriptError(script, line, "registration needs client id");
+        }
+        event->type = type[0] == 'r' ? SimEvent_Register : SimEvent_Deregister;
+        snprintf(event->clientId, sizeof(event->clientId), "%s", clientId);
+    } else {
+        scriptError(script, line, "unknown event");
+    }
+}
+
+static void parseLine(const char *script, int line, char *text) {
+    char *keyword = strtok(text, " \t\r\n");
+    char *argument;
+
+    if (keyword == NULL || keyword[0] == '#') {
+        return;
+    }
+
+    if (strcmp(keyword, "run_ms") == 0) {
+        argument = strtok(NULL, " \t\r\n");
+        if (argument == NULL) {
+            scriptError(script, line, "run_ms needs a duration");
+        }
+        runMs = atol(argument);
+    } else if (strcmp(keyword, "i2c_latency_ms") == 0 || strcmp(keyword, "i2c_fail_every") == 0 ||
+        strcmp(keyword, "awa_latency_ms") == 0) {
+        argument = strtok(NULL, " \t\r\n");
+        if (argument == NULL) {
+            scriptError(script, line, "missing value");
+        }
+        if (keyword[0] == 'a') {
+            g_SimConfig.awaLatencyMs = atol(argument);
+        } else if (strstr(keyword, "fail") != NULL) {
+            g_SimConfig.i2cFailEvery = atoi(argument);
+        } else {
+            g_SimConfig.i2cLatencyMs = atol(argument);
+        }
+    } else if (strcmp(keyword, "awa_outage") == 0) {
+        char *start = strtok(NULL, " \t\r\n");
+        char *duration = strtok(NULL, " \t\r\n");
+        if (start == NULL || duration == NULL) {
+            scriptError(script, line, "awa_outage needs start and duration");
+        }
+        g_SimConfig.awaOutageStartMs = atol(start);
+        g_SimConfig.awaOutageDurationMs = atol(duration);
+    } else if (strcmp(keyword, "series") == 0) {
+        Series *s;
+        argument = strtok(NULL, " \t\r\n");
+        if (argument == NULL || seriesCount == SIM_MAX_SERIES) {
+            scriptError(script, line, "bad series");
+        }
+        s = &series[seriesCount++];
+        snprintf(s->name, sizeof(s->name), "%s", argument);
+        while ((argument = strtok(NULL, " \t\r\n")) != NULL && s->count < SIM_MAX_SERIES_VALUES) {
+            s->values[s->count++] = atof(argument);
+        }
+        if (s->count == 0) {
+            scriptError(script, line, "series without values");
+        }
+    } else if (strcmp(keyword, "node") == 0) {
+        SimNodeResource *resource;
+        char *clientId = strtok(NULL, " \t\r\n");
+        char *path = strtok(NULL, " \t\r\n");
+        char *value = strtok(NULL, " \t\r\n");
+        char *step = strtok(NULL, " \t\r\n");
+        if (value == NULL || nodeResourceCount == SIM_MAX_NODE_RESOURCES) {
+            scriptError(script, line, "bad node");
+        }
+        resource = &nodeResources[nodeResourceCount++];
+        snprintf(resource->clientId, sizeof(resource->clientId), "%s", clientId);
+        snprintf(resource->path, sizeof(resource->path), "%s", path);
+        resource->value = atof(value);
+        resource->step = step != NULL ? atof(step) : 0;
+    } else if (strcmp(keyword, "node_latency") == 0) {
+        char *clientId = strtok(NULL, " \t\r\n");
+        char *latency = strtok(NULL, " \t\r\n");
+        char *from = strtok(NULL, " \t\r\n");
+        if (latency == NULL || nodeLatencyCount == SIM_MAX_NODE_LATENCIES) {
+            scriptError(script, line, "bad node_latency");
+        }
+        snprintf(nodeLatencies[nodeLatencyCount].clientId, SIM_CLIENT_ID_SIZE, "%s", clientId);
+        nodeLatencies[nodeLatencyCount].fromMs = from != NULL ? atol(from) : 0;
+        nodeLatencies[nodeLatencyCount++].latencyMs = atol(latency);
+    } else if (strcmp(keyword, "sensor_fault") == 0) {
+        char *slot = strtok(NULL, " \t\r\n");
+        char *start = strtok(NULL, " \t\r\n");
+        char *duration = strtok(NULL, " \t\r\n");
+        char *fault = strtok(NULL, " \t\r\n");
+        if (fault == NULL || (strcmp(fault, "fail") != 0 && strcmp(fault, "hang") != 0) ||
+            sensorFaultCount == SIM_MAX_SENSOR_FAULTS) {
+            scriptError(script, line, "bad sensor_fault");
+        }
+        sensorFaults[sensorFaultCount].bus = atoi(slot) - 1;
+        sensorFaults[sensorFaultCount].startMs = atol(start);
+        sensorFaults[sensorFaultCount].durationMs = atol(duration);
+        sensorFaults[sensorFaultCount++].fault = fault[0] == 'f' ? SimFault_Fail : SimFault_Hang;
+    } else if (strcmp(keyword, "event") == 0) {
+        char *at = strtok(NULL, " \t\r\n");
+        char *type = strtok(NULL, " \t\r\n");
+        if (type == NULL) {
+            scriptError(script, line, "event needs time and type");
+        }
+        addEvent(script, line, atol(at), type);
+    } else if (strcmp(keyword, "expect") == 0) {
+        Expectation *e;
+        char *end;
+        char *subject = strtok(NULL, " \t\r\n");
+        char *op = strtok(NULL, " \t\r\n");
+        char *value = strtok(NULL, " \t\r\n");
+        if (value == NULL || strlen(op) > 2 || expectationCount == SIM_MAX_EXPECTATIONS) {
+            scriptError(script, line, "bad expectation");
+        }
+        e = &expectations[expectationCount++];
+        snprintf(e->subject, sizeof(e->subject), "%s", subject);
+        snprintf(e->op, sizeof(e->op), "%s", op);
+        e->value = strtod(value, &end);
+        if (*end != '\0') {
+            char *sign = strpbrk(value, "+-");
+            e->value = 0;
+            if (sign != NULL) {
+                e->value = atof(sign);
+                *sign = '\0';
+            }
+            snprintf(e->reference, sizeof(e->reference), "%s", value);
+        }
+        e->line = line;
+    } else {
+        scriptError(script, line, "unknown keyword");
+    }
+}
+
+static void *stopAfterRun(void *context) {
+    (void)context;
+    simSleepMs(runMs);
+    kill(getpid(), SIGTERM);
+    return NULL;
+}
+
+static bool compare(double actual, const char *op, double expected) {
+    const double epsilon = 1e-4;
+
+    if (strcmp(op, "<") == 0) return actual < expected;
+    if (strcmp(op, "<=") == 0) return actual <= expected + epsilon;
+    if (strcmp(op, "==") == 0) return fabs(actual - expected) <= epsilon;
+    if (strcmp(op, "!=") == 0) return fabs(actual - expected) > epsilon;
+    if (strcmp(op, ">=") == 0) return actual >= expected - epsilon;
+    if (strcmp(op, ">") == 0) return actual > expected;
+    return false;
+}
+
+static bool lookupSubject(const char *subject, double *value) {
+    int i;
+
+    if (subject[0] == '/') {
+        return fakeAwaClientValue(subject, value);
+    }
+    for (i = 0; i < SimCounter_Count; i++) {
+        if (strcmp(counterNames[i], subject) == 0) {
+            *value = counters[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+__attribute__((constructor))
+static void simStart(void) {
+    const char *script = getenv(SIM_SCRIPT_ENV);
+    char text[SIM_LINE_SIZE];
+    int line = 0;
+    FILE *file;
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    if (script == NULL) {
+        return;
+    }
+
+    file = fopen(script, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Can't open simulation script %s\n", script);
+        exit(2);
+    }
+    while (fgets(text, sizeof(text), file) != NULL) {
+        parseLine(script, ++line, text);
+    }
+    fclose(file);
+
+    if (runMs >= 0) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, stopAfterRun, NULL);
+        pthread_detach(thread);
+    }
+}
+
+__attribute__((destructor))
+static void simVerify(void) {
+    bool passed = true;
+    int i;
+
+    simLock();
+    fprintf(stderr, "\nSimulation after %lld ms:", (long long)simElapsedMs());
+    for (i = 0; i < SimCounter_Count; i++) {
+        fprintf(stderr, " %s=%lu", counterNames[i], counters[i]);
+    }
+    fprintf(stderr, "\n");
+
+    for (i = 0; i < expectationCount; i++) {
+        Expectation *e = &expectations[i];
+        double actual = NAN;
+        double reference = 0;
+        bool found = lookupSubject(e->subject, &actual) &&
+            (e->reference[0] == '\0' || lookupSubject(e->reference, &reference));
+        bool ok = found && compare(actual, e->op, e->value + reference);
+        fprintf(stderr, "%s: expect %s %s %g, got %g\n", ok ? "PASS" : "FAIL", e->subject, e->op, e->value + reference,
+                actual);
+        passed = passed && ok;
+    }
+    simUnlock();
+
+    if (!passed) {
+        _exit(1);
+    }
+}
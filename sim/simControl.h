@@ -0,0 +1,154 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file simControl.h
+ * @brief Scenario script, fault injection and expectations shared by the stand-in Awa and LetMeCreate backends.
+ *
+ * The script named by WS_SIM_SCRIPT is loaded before main() runs. Lines are "keyword arguments", '#' starts a comment:
+ *   run_ms <ms>                          stop the daemon with SIGTERM after this long
+ *   series <name> <value>...             values returned by the sensor, cycled (thermo3, temperature, pressure,
+ *                                        humidity, co, air); skipped BME280
+ *                                        channels read as 0
+ *   i2c_latency_ms <ms>                  delay of every I2C sensor read
+ *   i2c_fail_every <n>                   every n-th I2C sensor read fails
+ *   awa_latency_ms <ms>                  delay of every Awa operation
+ *   awa_outage <start ms> <duration ms>  Awa daemons unreachable within this window
+ *   node <client id> <path> <value> [<step>]  resource of a remote LWM2M client, step is added on every read/notify
+ *   node_latency <client id> <ms> [<from ms>]  delay of every read of the client from the given time on, reads
+ *                                        time out when it is too long
+ *   sensor_fault <slot> <start ms> <duration ms> fail|hang  reads of the click in slot 1 or 2 fail within this
+ *                                        window, or block until it ends
+ *   event <at ms> lightning <km> <energy> | disturber | noise   interrupt raised by the Thunder click
+ *   event <at ms> register <client id> | deregister <client id>
+ *                                        client (de)registers with the server, clients with resources are registered
+ *                                        from the start unless their first event is register
+ *   expect <path|counter> <op> <value>   checked when the daemon exits, op is one of < <= == >= > !=, value is a
+ *                                        number or another path or counter, optionally with +<n> or -<n> added
+ * A failed expectation makes the process exit with status 1.
+ */
+
+#ifndef SIM_CONTROL_H
+#define SIM_CONTROL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! \{
+#define SIM_PATH_SIZE       (64)
+#define SIM_CLIENT_ID_SIZE  (32)
+//! \}
+
+typedef enum {
+    SimCounter_ClientOps,
+    SimCounter_SetOps,
+    SimCounter_GetOps,
+    SimCounter_ServerOps,
+    SimCounter_Connects,
+    SimCounter_FailedOps,
+    SimCounter_SensorReads,
+    SimCounter_SensorFailures,
+    SimCounter_I2CViolations,
+    SimCounter_Notifications,
+    SimCounter_Interrupts,
+    SimCounter_SpiTransfers,
+    SimCounter_Conversions,     /**< forced BME280 conversions */
+    SimCounter_StaleReads,      /**< BME280 reads in forced mode without a finished conversion */
+    SimCounter_NodeTimeouts,    /**< server reads which timed out on a slow client */
+    SimCounter_DefineOps,       /**< define ops on the local client */
+    SimCounter_SensorValues,    /**< sensor values (5700) stored by the local client */
+    SimCounter_Count
+} SimCounter;
+
+typedef struct {
+    char clientId[SIM_CLIENT_ID_SIZE];
+    char path[SIM_PATH_SIZE];
+    double value;
+    double step;
+} SimNodeResource;
+
+typedef enum {
+    SimEvent_Lightning,
+    SimEvent_Disturber,
+    SimEvent_Noise,
+    SimEvent_Register,
+    SimEvent_Deregister
+} SimEventType;
+
+typedef struct {
+    long atMs;
+    SimEventType type;
+    int distance;
+    unsigned int energy;
+    char clientId[SIM_CLIENT_ID_SIZE];
+} SimEvent;
+
+typedef enum {
+    SimFault_None,
+    SimFault_Fail,
+    SimFault_Hang
+} SimFault;
+
+typedef struct {
+    long awaLatencyMs;
+    long awaOutageStartMs;
+    long awaOutageDurationMs;
+    long i2cLatencyMs;
+    int i2cFailEvery;
+} SimConfig;
+
+extern SimConfig g_SimConfig;
+
+/** Serializes access to the state of the fakes, they are called from several daemon threads. */
+void simLock(void);
+void simUnlock(void);
+
+void simCount(SimCounter counter);
+
+/** Milliseconds since the process started. */
+int64_t simElapsedMs(void);
+
+void simSleepMs(long ms);
+
+/** True while the scripted Awa outage lasts. */
+bool simAwaOutage(void);
+
+/** Next value of the named series, fallback when the script defines none. */
+double simNextValue(const char *name, double fallback);
+
+/** Remote resource of the client at the given index, NULL past the last one. */
+SimNodeResource *simNodeResource(int index);
+
+/** Scripted event at the given index, NULL past the last one. Events are sorted by time. */
+const SimEvent *simEvent(int index);
+
+/** True when the client has resources and is registered with the server by now. */
+bool simNodeRegistered(const char *clientId);
+
+/** Scripted delay of reads of the client. */
+long simNodeLatencyMs(const char *clientId);
+
+/** Fault of the click on the mikroBUS index by now, *remainingMs is set to the time until it ends. */
+SimFault simSensorFault(int bus, long *remainingMs);
+
+/** Implemented by the Awa stand-in, used to check expectations on the local client's resources. */
+bool fakeAwaClientValue(const char *path, double *value);
+
+#endif  /* SIM_CONTROL_H */
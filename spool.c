@@ -0,0 +1,286 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "spool.h"
+#include "log.h"
+
+#define SPOOL_MAGIC         (0x50535357)    // "WSSP"
+#define SPOOL_VERSION       (2)
+#define SPOOL_HEADER_SIZE   (4096)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t acknowledged;  /**< sequence of the last record replayed */
+} SpoolHeader;
+
+typedef struct {
+    uint32_t sequence;      /**< starts at 1, zero marks empty record */
+    uint32_t crc;           /**< CRC-32 of the record with this field zeroed */
+    int64_t seconds;
+    int32_t nanoseconds;
+    int32_t objectId;
+    int32_t instance;
+    uint32_t count;
+    double value;
+    double min;
+    double max;
+    double stddev;
+} SpoolRecord;
+
+static int fd = -1;
+static uint8_t *map = NULL;
+static size_t mapSize = 0;
+static SpoolHeader *header = NULL;
+static SpoolRecord *records = NULL;
+static uint32_t head = 1;           // sequence of the next record written
+static uint32_t tail = 1;           // sequence of the oldest record not replayed
+static uint32_t firstDirty = 0;     // range of records appended since last sync
+static uint32_t lastDirty = 0;
+static unsigned long overwritten = 0;
+
+static uint32_t crc32(const uint8_t *data, size_t length) {
+    static uint32_t table[256];
+    static bool tableReady = false;
+    uint32_t crc = 0xFFFFFFFF;
+    size_t index;
+
+    if (!tableReady) {
+        uint32_t value, bit;
+        for (value = 0; value < 256; value++) {
+            uint32_t entry = value;
+            for (bit = 0; bit < 8; bit++) {
+                entry = (entry & 1) ? (entry >> 1) ^ 0xEDB88320 : entry >> 1;
+            }
+            table[value] = entry;
+        }
+        tableReady = true;
+    }
+
+    for (index = 0; index < length; index++) {
+        crc = table[(crc ^ data[index]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+static uint32_t recordCrc(const SpoolRecord *record) {
+    SpoolRecord copy = *record;
+    copy.crc = 0;
+    return crc32((const uint8_t *)&copy, sizeof(copy));
+}
+
+static SpoolRecord *recordAt(uint32_t sequence) {
+    return &records[(sequence - 1) % header->capacity];
+}
+
+static bool isValid(const SpoolRecord *record, uint32_t sequence) {
+    return record->sequence == sequence && record->crc == recordCrc(record);
+}
+
+/** Rebuild ring position from the records found in the file. */
+static void recover(void) {
+    uint32_t index;
+    uint32_t newest = 0;
+
+    for (index = 0; index < header->capacity; index++) {
+        const SpoolRecord *record = &records[index];
+        if (record->sequence != 0 && record->sequence > newest && record->crc == recordCrc(record)) {
+            newest = record->sequence;
+        }
+    }
+
+    head = newest + 1;
+    if (head <= header->acknowledged) {
+        head = header->acknowledged + 1;
+    }
+    tail = header->acknowledged + 1;
+    if (head - tail > header->capacity) {
+        tail = head - header->capacity;
+    }
+}
+
+bool spoolOpen(const char *path, unsigned int capacity) {
+    struct stat info;
+
+    mapSize = SPOOL_HEADER_SIZE + (size_t)capacity * sizeof(SpoolRecord);
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        LOG(LOG_ERROR, "Can't open spool %s", path);
+        spoolClose();
+        return false;
+    }
+
+    bool fresh = (size_t)info.st_size != mapSize;
+    if (fresh && (ftruncate(fd, 0) != 0 || ftruncate(fd, mapSize) != 0)) {
+        LOG(LOG_ERROR, "Can't resize spool %s", path);
+        spoolClose();
+        return false;
+    }
+
+    map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        LOG(LOG_ERROR, "Can't map spool %s", path);
+        map = NULL;
+        spoolClose();
+        return false;
+    }
+    header = (SpoolHeader *)map;
+    records = (SpoolRecord *)(map + SPOOL_HEADER_SIZE);
+
+    if (fresh || header->magic != SPOOL_MAGIC || header->version != SPOOL_VERSION || header->capacity != capacity) {
+        // freshly truncated file reads as zeros already, don't wear flash by clearing it
+        if (!fresh) {
+            memset(map, 0, mapSize);
+            msync(map, mapSize, MS_SYNC);
+        }
+        header->magic = SPOOL_MAGIC;
+        header->version = SPOOL_VERSION;
+        header->capacity = capacity;
+        header->acknowledged = 0;
+        msync(map, SPOOL_HEADER_SIZE, MS_SYNC);
+    }
+
+    recover();
+    LOG(LOG_INFO, "Spool %s opened, %u records waiting for replay", path, spoolPending());
+    return true;
+}
+
+bool spoolAppend(const Sample *sample) {
+    if (records == NULL) {
+        return false;
+    }
+
+    uint32_t sequence = head++;
+    SpoolRecord *record = recordAt(sequence);
+    record->sequence = sequence;
+    record->seconds = sample->timestamp.tv_sec;
+    record->nanoseconds = sample->timestamp.tv_nsec;
+    record->objectId = sample->objectId;
+    record->instance = sample->instance;
+    record->count = sample->count;
+    record->value = sample->value;
+    record->min = sample->min;
+    record->max = sample->max;
+    record->stddev = sample->stddev;
+    record->crc = recordCrc(record);
+
+    if (head - tail > header->capacity) {
+        tail++;
+        overwritten++;
+        if (overwritten % header->capacity == 1) {
+            LOG(LOG_WARN, "Spool full, oldest records are overwritten");
+        }
+    }
+
+    if (firstDirty == 0) {
+        firstDirty = sequence;
+    }
+    lastDirty = sequence;
+    return true;
+}
+
+/** Sync pages holding records of sequences first..last, taking wrap around of the ring into account. */
+static void syncRecords(uint32_t first, uint32_t last) {
+    long pageSize = sysconf(_SC_PAGESIZE);
+    uint32_t firstIndex = (first - 1) % header->capacity;
+    uint32_t lastIndex = (last - 1) % header->capacity;
+
+    if (last - first >= header->capacity || lastIndex < firstIndex) {
+        msync(records, (size_t)header->capacity * sizeof(SpoolRecord), MS_SYNC);
+        return;
+    }
+
+    uintptr_t start = (uintptr_t)&records[firstIndex] & ~(uintptr_t)(pageSize - 1);
+    uintptr_t end = (uintptr_t)&records[lastIndex + 1];
+    msync((void *)start, end - start, MS_SYNC);
+}
+
+void spoolSync(void) {
+    if (records == NULL || firstDirty == 0) {
+        return;
+    }
+    syncRecords(firstDirty, lastDirty);
+    firstDirty = 0;
+    lastDirty = 0;
+}
+
+unsigned int spoolPending(void) {
+    return records != NULL ? head - tail : 0;
+}
+
+int spoolReplay(SpoolPublishFunc publish) {
+    Sample batch[SPOOL_REPLAY_BATCH];
+    int count = 0;
+    uint32_t sequence;
+
+    if (records == NULL || tail == head) {
+        return 0;
+    }
+
+    for (sequence = tail; sequence != head && count < SPOOL_REPLAY_BATCH; sequence++) {
+        const SpoolRecord *record = recordAt(sequence);
+        if (!isValid(record, sequence)) {
+            // torn by a power cut, nothing to recover from it
+            continue;
+        }
+        batch[count].timestamp.tv_sec = record->seconds;
+        batch[count].timestamp.tv_nsec = record->nanoseconds;
+        batch[count].objectId = record->objectId;
+        batch[count].instance = record->instance;
+        batch[count].value = record->value;
+        batch[count].min = record->min;
+        batch[count].max = record->max;
+        batch[count].stddev = record->stddev;
+        batch[count].count = record->count;
+        count++;
+    }
+
+    if (count > 0 && !publish(batch, count)) {
+        return -1;
+    }
+
+    int consumed = sequence - tail;
+    tail = sequence;
+    header->acknowledged = tail - 1;
+    msync(map, SPOOL_HEADER_SIZE, MS_SYNC);
+    LOG(LOG_DEBUG, "Replayed %d spooled samples, %u pending", count, spoolPending());
+    return consumed;
+}
+
+void spoolClose(void) {
+    spoolSync();
+    if (map != NULL) {
+        munmap(map, mapSize);
+        map = NULL;
+        header = NULL;
+        records = NULL;
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
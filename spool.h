@@ -0,0 +1,65 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file spool.h
+ * @brief Store-and-forward buffer keeping samples on flash while they can't be published.
+ *
+ * The spool is a memory mapped ring file of fixed size records. Every record carries its sequence number and CRC, so
+ * after a crash the ring is rebuilt by scanning the file and torn records are skipped. Only the replay position is
+ * kept in the header page.
+ */
+
+#ifndef SPOOL_H
+#define SPOOL_H
+
+#include <stdbool.h>
+#include "sampleQueue.h"
+
+#define DEFAULT_SPOOL_FILE          "/etc/weather_station_spool"
+/** Default capacity in records, 64 bytes each. */
+#define DEFAULT_SPOOL_CAPACITY      (32768)
+/** Maximum number of records handed over by one replay call. */
+#define SPOOL_REPLAY_BATCH          (64)
+
+/** Publishes replayed samples, returns false if they have to stay in the spool. */
+typedef bool (*SpoolPublishFunc)(const Sample *samples, int count);
+
+/** Open or create spool file with capacity records, recovering records left there. */
+bool spoolOpen(const char *path, unsigned int capacity);
+
+/** Store sample, the oldest record is overwritten when the spool is full. */
+bool spoolAppend(const Sample *sample);
+
+/** Flush records appended since last call to the flash. */
+void spoolSync(void);
+
+/** Number of records waiting for replay. */
+unsigned int spoolPending(void);
+
+/**
+ * Pass up to SPOOL_REPLAY_BATCH oldest records to publish and drop them from the spool when it succeeds. Returns
+ * number of records consumed or -1 when publishing failed.
+ */
+int spoolReplay(SpoolPublishFunc publish);
+
+void spoolClose(void);
+
+#endif  /* SPOOL_H */
@@ -0,0 +1,293 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <stdatomic.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include "ipsoCommon.h"
+#include "stats.h"
+#include "awaSession.h"
+#include "trace.h"
+#include "log.h"
+
+//! \{
+#define STATS_RESOURCE_COUNT        (0)
+#define STATS_RESOURCE_ERRORS       (1)
+#define STATS_RESOURCE_TIMEOUTS     (2)
+#define STATS_RESOURCE_MEAN         (3)
+#define STATS_RESOURCE_P99          (4)
+#define STATS_RESOURCE_MAX          (5)
+#define STATS_RESOURCE_OVER_PERIOD  (6)
+//! \}
+
+typedef struct {
+    atomic_ulong count;
+    atomic_ulong errors;
+    atomic_ulong timeouts;
+    atomic_ulong overPeriod;
+    atomic_ullong totalUs;
+    atomic_ullong maxUs;
+    atomic_ulong buckets[STATS_BUCKETS];
+} StageStats;
+
+static const char *stageNames[StatsStage_Count] = {
+    "sensorRead", "extremesGet", "publish", "create", "connect", "remoteRead", "observe", "spoolWrite",
+    "spoolReplay", "acquire", "publishCycle", "event", "requestWait", "define"
+};
+
+static StageStats stages[StatsStage_Count];
+static volatile sig_atomic_t dumpRequested = 0;
+static bool instancesCreated = false;
+
+int64_t statsStart(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/** Values below 4 us get a bucket each, above that every power of two is split into four buckets. */
+static int bucketOf(uint64_t us) {
+    int msb;
+    int index;
+
+    if (us < 4) {
+        return (int)us;
+    }
+    msb = 63 - __builtin_clzll(us);
+    index = (msb - 1) * 4 + (int)((us >> (msb - 2)) & 3);
+    return index < STATS_BUCKETS ? index : STATS_BUCKETS - 1;
+}
+
+static uint64_t bucketUpperUs(int index) {
+    if (index < 4) {
+        return index + 1;
+    }
+    return (uint64_t)(5 + index % 4) << (index / 4 - 1);
+}
+
+static void record(StatsStage stage, uint64_t us, StatsOutcome outcome) {
+    StageStats *stats = &stages[stage];
+    unsigned long long max = atomic_load_explicit(&stats->maxUs, memory_order_relaxed);
+
+    atomic_fetch_add_explicit(&stats->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->totalUs, us, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->buckets[bucketOf(us)], 1, memory_order_relaxed);
+    while (us > max && !atomic_compare_exchange_weak_explicit(&stats->maxUs, &max, us, memory_order_relaxed,
+                                                              memory_order_relaxed));
+    if (outcome == StatsOutcome_Error) {
+        atomic_fetch_add_explicit(&stats->errors, 1, memory_order_relaxed);
+    } else if (outcome == StatsOutcome_Timeout) {
+        atomic_fetch_add_explicit(&stats->timeouts, 1, memory_order_relaxed);
+    }
+}
+
+void statsRecord(StatsStage stage, int64_t startUs, StatsOutcome outcome) {
+    int64_t us = statsStart() - startUs;
+    record(stage, us > 0 ? (uint64_t)us : 0, outcome);
+    traceStage(stage, us > 0 ? (uint64_t)us : 0, outcome);
+}
+
+void statsRecordCycle(StatsStage stage, int64_t startUs, long periodMs) {
+    int64_t us = statsStart() - startUs;
+
+    record(stage, us > 0 ? (uint64_t)us : 0, StatsOutcome_Ok);
+    if (periodMs > 0 && us > (int64_t)periodMs * 1000) {
+        atomic_fetch_add_explicit(&stages[stage].overPeriod, 1, memory_order_relaxed);
+    }
+}
+
+StatsOutcome statsAwaOutcome(AwaError result) {
+    switch (result) {
+        case AwaError_Success:
+            return StatsOutcome_Ok;
+        case AwaError_Timeout:
+            return StatsOutcome_Timeout;
+        default:
+            return StatsOutcome_Error;
+    }
+}
+
+unsigned long statsCount(StatsStage stage) {
+    return atomic_load_explicit(&stages[stage].count, memory_order_relaxed);
+}
+
+double statsPercentileMs(StatsStage stage, double fraction) {
+    StageStats *stats = &stages[stage];
+    unsigned long count = atomic_load_explicit(&stats->count, memory_order_relaxed);
+    uint64_t maxUs = atomic_load_explicit(&stats->maxUs, memory_order_relaxed);
+    unsigned long seen = 0;
+    int index;
+
+    if (count == 0) {
+        return 0;
+    }
+    for (index = 0; index < STATS_BUCKETS - 1; index++) {
+        seen += atomic_load_explicit(&stats->buckets[index], memory_order_relaxed);
+        if (seen >= fraction * count) {
+            break;
+        }
+    }
+    // bucket bound may lie above anything measured
+    return (bucketUpperUs(index) < maxUs ? bucketUpperUs(index) : maxUs) / 1000.0;
+}
+
+static double meanMs(const StageStats *stats, unsigned long count) {
+    return count > 0 ? atomic_load_explicit(&stats->totalUs, memory_order_relaxed) / 1000.0 / count : 0;
+}
+
+bool statsFormatStage(StatsStage stage, char *line, size_t size) {
+    StageStats *stats = &stages[stage];
+    unsigned long count = atomic_load_explicit(&stats->count, memory_order_relaxed);
+
+    if (count == 0) {
+        return false;
+    }
+    snprintf(line, size, "%-12s count=%lu errors=%lu timeouts=%lu mean=%.3fms p50=%.3fms p99=%.3fms max=%.3fms"
+             " overPeriod=%lu", stageNames[stage], count,
+             atomic_load_explicit(&stats->errors, memory_order_relaxed),
+             atomic_load_explicit(&stats->timeouts, memory_order_relaxed), meanMs(stats, count),
+             statsPercentileMs(stage, 0.5), statsPercentileMs(stage, 0.99),
+             atomic_load_explicit(&stats->maxUs, memory_order_relaxed) / 1000.0,
+             atomic_load_explicit(&stats->overPeriod, memory_order_relaxed));
+    return true;
+}
+
+void statsWrite(FILE *stream) {
+    char line[STATS_LINE_SIZE];
+    int stage;
+
+    for (stage = 0; stage < StatsStage_Count; stage++) {
+        if (statsFormatStage(stage, line, sizeof(line))) {
+            fprintf(stream, "%s\n", line);
+        }
+    }
+}
+
+void statsRequestDump(void) {
+    dumpRequested = 1;
+}
+
+bool statsDumpRequested(void) {
+    if (!dumpRequested) {
+        return false;
+    }
+    dumpRequested = 0;
+    return true;
+}
+
+static void addInteger(AwaClientSetOperation *operation, int stage, int resource, unsigned long value) {
+    char path[IPSO_PATH_SIZE];
+    sprintf(path, "/%d/%d/%d", STATS_OBJECT_ID, stage, resource);
+    AwaClientSetOperation_AddValueAsInteger(operation, path, value);
+}
+
+static void addFloat(AwaClientSetOperation *operation, int stage, int resource, double value) {
+    char path[IPSO_PATH_SIZE];
+    sprintf(path, "/%d/%d/%d", STATS_OBJECT_ID, stage, resource);
+    AwaClientSetOperation_AddValueAsFloat(operation, path, value);
+}
+
+static AwaError performPublish(AwaClientSession *session, bool create) {
+    char path[IPSO_PATH_SIZE];
+    int stage;
+    AwaClientSetOperation *operation = AwaClientSetOperation_New(session);
+    if (operation == NULL) {
+        LOG(LOG_ERROR, "AwaClientSetOperation_New() failed");
+        return AwaError_OutOfMemory;
+    }
+
+    for (stage = 0; stage < StatsStage_Count; stage++) {
+        StageStats *stats = &stages[stage];
+        unsigned long count = atomic_load_explicit(&stats->count, memory_order_relaxed);
+
+        if (create) {
+            sprintf(path, "/%d/%d", STATS_OBJECT_ID, stage);
+            AwaClientSetOperation_CreateObjectInstance(operation, path);
+        }
+        addInteger(operation, stage, STATS_RESOURCE_COUNT, count);
+        addInteger(operation, stage, STATS_RESOURCE_ERRORS, atomic_load_explicit(&stats->errors, memory_order_relaxed));
+        addInteger(operation, stage, STATS_RESOURCE_TIMEOUTS,
+                   atomic_load_explicit(&stats->timeouts, memory_order_relaxed));
+        addFloat(operation, stage, STATS_RESOURCE_MEAN, meanMs(stats, count));
+        addFloat(operation, stage, STATS_RESOURCE_P99, statsPercentileMs(stage, 0.99));
+        addFloat(operation, stage, STATS_RESOURCE_MAX,
+                 atomic_load_explicit(&stats->maxUs, memory_order_relaxed) / 1000.0);
+        addInteger(operation, stage, STATS_RESOURCE_OVER_PERIOD,
+                   atomic_load_explicit(&stats->overPeriod, memory_order_relaxed));
+    }
+
+    int64_t start = statsStart();
+    AwaError result = AwaClientSetOperation_Perform(operation, awaSessionTimeoutMs());
+    awaSessionMeasure(start, result);
+    AwaClientSetOperation_Free(&operation);
+    return result;
+}
+
+AwaObjectDefinition *statsNewDefinition(void) {
+    AwaObjectDefinition *definition = AwaObjectDefinition_New(STATS_OBJECT_ID, "Weather Station Stats", 0, AWA_MAX_ID);
+    if (definition == NULL) {
+        return NULL;
+    }
+
+    AwaObjectDefinition_AddResourceDefinitionAsInteger(definition, STATS_RESOURCE_COUNT, "Count", true,
+                                                       AwaResourceOperations_ReadOnly, 0);
+    AwaObjectDefinition_AddResourceDefinitionAsInteger(definition, STATS_RESOURCE_ERRORS, "Errors", true,
+                                                       AwaResourceOperations_ReadOnly, 0);
+    AwaObjectDefinition_AddResourceDefinitionAsInteger(definition, STATS_RESOURCE_TIMEOUTS, "Timeouts", true,
+                                                       AwaResourceOperations_ReadOnly, 0);
+    AwaObjectDefinition_AddResourceDefinitionAsFloat(definition, STATS_RESOURCE_MEAN, "Mean Latency", true,
+                                                     AwaResourceOperations_ReadOnly, 0);
+    AwaObjectDefinition_AddResourceDefinitionAsFloat(definition, STATS_RESOURCE_P99, "P99 Latency", true,
+                                                     AwaResourceOperations_ReadOnly, 0);
+    AwaObjectDefinition_AddResourceDefinitionAsFloat(definition, STATS_RESOURCE_MAX, "Max Latency", true,
+                                                     AwaResourceOperations_ReadOnly, 0);
+    AwaObjectDefinition_AddResourceDefinitionAsInteger(definition, STATS_RESOURCE_OVER_PERIOD, "Over Period", true,
+                                                       AwaResourceOperations_ReadOnly, 0);
+    return definition;
+}
+
+void statsAddInstances(AwaClientSetOperation *operation) {
+    char path[IPSO_PATH_SIZE];
+    int stage;
+
+    for (stage = 0; stage < StatsStage_Count; stage++) {
+        sprintf(path, "/%d/%d", STATS_OBJECT_ID, stage);
+        AwaClientSetOperation_CreateObjectInstance(operation, path);
+    }
+    // a failed publish creates them again
+    instancesCreated = true;
+}
+
+AwaError statsPublish(AwaClientSession *session) {
+    AwaError result = performPublish(session, !instancesCreated);
+
+    // instances left by an earlier run make the create fail, set again without it
+    if (result == AwaError_Response && !instancesCreated) {
+        result = performPublish(session, false);
+    }
+    if (result == AwaError_Success) {
+        instancesCreated = true;
+    } else if (result == AwaError_Response) {
+        instancesCreated = false;
+    }
+    LOG(LOG_DEBUG, "Awa stats publish response: %d", result);
+    return result;
+}
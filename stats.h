@@ -0,0 +1,108 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file stats.h
+ * @brief Latency histograms, error and timeout counters of the measurement and publishing stages.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <awa/common.h>
+#include <awa/client.h>
+
+/** Buckets of a histogram, four per power of two microseconds up to ~50 s. */
+#define STATS_BUCKETS           (104)
+#define STATS_LINE_SIZE         (192)
+#define DEFAULT_STATS_FILE      "/tmp/weather_station_stats"
+/** Custom LWM2M object publishing the stats, one instance per stage. Lies in the private objects range. */
+#define STATS_OBJECT_ID         (26241)
+
+typedef enum {
+    StatsStage_SensorRead = 0,  /**< click read, including wait for the I2C bus */
+    StatsStage_ExtremesGet,     /**< get op seeding 5601/5602 from the client daemon */
+    StatsStage_Publish,         /**< batch set op of a cycle */
+    StatsStage_Create,          /**< set op creating missing instances and resources */
+    StatsStage_Connect,         /**< connect to the client daemon */
+    StatsStage_RemoteRead,      /**< read op of the remote node */
+    StatsStage_Observe,         /**< write attributes and observe ops of the remote node */
+    StatsStage_SpoolWrite,      /**< samples appended to the spool and synced */
+    StatsStage_SpoolReplay,     /**< one replayed batch of the spool */
+    StatsStage_Acquire,         /**< producer cycle, compared with its period */
+    StatsStage_PublishCycle,    /**< main loop cycle from samples drained to published or spooled */
+    StatsStage_Event,           /**< click event from its interrupt to values ready for publishing */
+    StatsStage_RequestWait,     /**< Awa server request waiting in the window until a worker takes it */
+    StatsStage_Define,          /**< define op of objects missing from the client daemon */
+    StatsStage_Count
+} StatsStage;
+
+typedef enum {
+    StatsOutcome_Ok = 0,
+    StatsOutcome_Error,
+    StatsOutcome_Timeout
+} StatsOutcome;
+
+/** Current time in microseconds, start of a measured stage. */
+int64_t statsStart(void);
+
+/** Account stage started at startUs. Lock-free, safe to call from any thread. */
+void statsRecord(StatsStage stage, int64_t startUs, StatsOutcome outcome);
+
+/** Account periodic stage, cycles longer than periodMs are counted as over period. */
+void statsRecordCycle(StatsStage stage, int64_t startUs, long periodMs);
+
+/** Map result of an Awa operation, AwaError_Response counts as an error too. */
+StatsOutcome statsAwaOutcome(AwaError result);
+
+/** Number of times the stage ran. */
+unsigned long statsCount(StatsStage stage);
+
+/** Upper bound of the latency in ms below which the given fraction (0..1) of the stage's samples fall. */
+double statsPercentileMs(StatsStage stage, double fraction);
+
+/** Format one line describing the stage, returns false when the stage never ran. */
+bool statsFormatStage(StatsStage stage, char *line, size_t size);
+
+/** Write lines of all stages which ran. */
+void statsWrite(FILE *stream);
+
+/** Ask for a dump from a signal handler, async-signal-safe. */
+void statsRequestDump(void);
+
+/** Check and clear the dump request. */
+bool statsDumpRequested(void);
+
+/**
+ * Set count, errors, timeouts and latencies of every stage into instances of STATS_OBJECT_ID. Instances are created
+ * with the first publish and again whenever the client daemon lost them.
+ */
+AwaError statsPublish(AwaClientSession *session);
+
+/** Definition of STATS_OBJECT_ID for the client daemon, NULL when out of memory. Caller frees it. */
+AwaObjectDefinition *statsNewDefinition(void);
+
+/** Queue creation of the instances into operation, publishing then takes them as created. */
+void statsAddInstances(AwaClientSetOperation *operation);
+
+#endif  /* STATS_H */
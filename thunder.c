@@ -0,0 +1,288 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <string.h>
+#include <time.h>
+#include <letmecreate/letmecreate.h>
+#include "thunder.h"
+#include "scheduler.h"
+#include "stats.h"
+#include "log.h"
+
+//! \{
+#define AS3935_REG_AFE              (0x00)
+#define AS3935_REG_NOISE            (0x01)
+#define AS3935_REG_INTERRUPT        (0x03)
+#define AS3935_REG_ENERGY_LSB       (0x04)
+#define AS3935_REG_ENERGY_MSB       (0x05)
+#define AS3935_REG_ENERGY_MMSB      (0x06)
+#define AS3935_REG_DISTANCE         (0x07)
+#define AS3935_REG_TUNING           (0x08)
+#define AS3935_CMD_PRESET_DEFAULT   (0x3C)
+#define AS3935_CMD_CALIB_RCO        (0x3D)
+#define AS3935_DIRECT_COMMAND       (0x96)
+#define AS3935_READ                 (0x40)
+#define AS3935_AFE_OUTDOOR          (0x0E << 1)
+#define AS3935_NOISE_FLOOR_SHIFT    (4)
+#define AS3935_NOISE_FLOOR_MASK     (0x70)
+#define AS3935_NOISE_FLOOR_DEFAULT  (2)
+#define AS3935_MASK_DISTURBER       (0x20)
+#define AS3935_DISPLAY_TRCO         (0x20)
+#define AS3935_INT_NOISE            (0x01)
+#define AS3935_INT_DISTURBER        (0x04)
+#define AS3935_INT_LIGHTNING        (0x08)
+#define AS3935_INT_MASK             (0x0F)
+/** Time the sensor needs after raising IRQ before the interrupt register is valid. */
+#define AS3935_INT_SETTLE_MS        (2)
+//! \}
+
+static pthread_mutex_t spiMutex = PTHREAD_MUTEX_INITIALIZER;
+static sem_t interruptRaised;
+static volatile int64_t interruptUs;
+static int callbackId = -1;
+static uint8_t thunderBus;
+static bool started = false;
+
+static ThunderStats stats;
+static int64_t strikeTimes[THUNDER_STRIKE_HISTORY];
+static unsigned int strikeCount = 0;
+static int64_t disturberTimes[THUNDER_DISTURBER_BURST];
+static int64_t noiseTimes[THUNDER_NOISE_BURST];
+static int64_t maskedUntil = 0;
+static int64_t lastNoise = 0;
+
+static bool writeRegister(uint8_t address, uint8_t value) {
+    uint8_t tx[2] = { address & 0x3F, value };
+    uint8_t rx[2];
+
+    pthread_mutex_lock(&spiMutex);
+    spi_select_bus(thunderBus);
+    int result = spi_transfer(tx, rx, sizeof(tx));
+    pthread_mutex_unlock(&spiMutex);
+    return result >= 0;
+}
+
+static bool readRegister(uint8_t address, uint8_t *value) {
+    uint8_t tx[2] = { AS3935_READ | (address & 0x3F), 0 };
+    uint8_t rx[2] = { 0, 0 };
+
+    pthread_mutex_lock(&spiMutex);
+    spi_select_bus(thunderBus);
+    int result = spi_transfer(tx, rx, sizeof(tx));
+    pthread_mutex_unlock(&spiMutex);
+    *value = rx[1];
+    return result >= 0;
+}
+
+static bool updateRegister(uint8_t address, uint8_t mask, uint8_t bits) {
+    uint8_t value;
+    return readRegister(address, &value) && writeRegister(address, (value & ~mask) | (bits & mask));
+}
+
+/** Runs on the GPIO monitor thread, work is left to the thread waiting for strikes. */
+static void interruptCallback(uint8_t event) {
+    (void)event;
+    interruptUs = statsStart();
+    sem_post(&interruptRaised);
+}
+
+/** Remember event at now, true when the last count events all fit into the burst window. */
+static bool burst(int64_t *times, int count, int64_t now) {
+    int index;
+
+    for (index = 0; index < count - 1; index++) {
+        times[index] = times[index + 1];
+    }
+    times[count - 1] = now;
+    return times[0] != 0 && now - times[0] < THUNDER_BURST_WINDOW_MS;
+}
+
+static void setNoiseFloor(int level) {
+    if (updateRegister(AS3935_REG_NOISE, AS3935_NOISE_FLOOR_MASK, level << AS3935_NOISE_FLOOR_SHIFT)) {
+        stats.noiseFloor = level;
+        LOG(LOG_INFO, "Thunder noise floor threshold set to %d", level);
+    }
+}
+
+static void handleDisturber(int64_t now) {
+    stats.disturbers++;
+    if (burst(disturberTimes, THUNDER_DISTURBER_BURST, now) && maskedUntil == 0) {
+        LOG(LOG_WARN, "%d disturbers within %d s, masking them for %d s", THUNDER_DISTURBER_BURST,
+            THUNDER_BURST_WINDOW_MS / 1000, THUNDER_MASK_HOLDOFF_MS / 1000);
+        if (updateRegister(AS3935_REG_INTERRUPT, AS3935_MASK_DISTURBER, AS3935_MASK_DISTURBER)) {
+            maskedUntil = now + THUNDER_MASK_HOLDOFF_MS;
+            stats.masked++;
+        }
+    }
+}
+
+static void handleNoise(int64_t now) {
+    stats.noise++;
+    lastNoise = now;
+    if (burst(noiseTimes, THUNDER_NOISE_BURST, now) && stats.noiseFloor < 7) {
+        setNoiseFloor(stats.noiseFloor + 1);
+        // next step needs a burst of its own
+        memset(noiseTimes, 0, sizeof(noiseTimes));
+    }
+}
+
+/** Undo masking and raised noise floor once things calmed down. */
+static void recover(int64_t now) {
+    if (maskedUntil != 0 && now >= maskedUntil &&
+        updateRegister(AS3935_REG_INTERRUPT, AS3935_MASK_DISTURBER, 0)) {
+        LOG(LOG_INFO, "Thunder disturbers unmasked");
+        maskedUntil = 0;
+    }
+    if (stats.noiseFloor > AS3935_NOISE_FLOOR_DEFAULT && now - lastNoise >= THUNDER_NOISE_RECOVERY_MS) {
+        setNoiseFloor(stats.noiseFloor - 1);
+        lastNoise = now;
+    }
+}
+
+static bool readStrike(ThunderStrike *strike) {
+    uint8_t energy[3];
+    uint8_t distance;
+
+    if (!readRegister(AS3935_REG_ENERGY_LSB, &energy[0]) || !readRegister(AS3935_REG_ENERGY_MSB, &energy[1]) ||
+        !readRegister(AS3935_REG_ENERGY_MMSB, &energy[2]) || !readRegister(AS3935_REG_DISTANCE, &distance)) {
+        return false;
+    }
+    strike->energy = ((uint32_t)(energy[2] & 0x1F) << 16) | ((uint32_t)energy[1] << 8) | energy[0];
+    strike->distance = distance & 0x3F;
+    return true;
+}
+
+bool thunderStart(uint8_t bus) {
+    uint8_t pin = bus == MIKROBUS_1 ? MIKROBUS_1_INT : MIKROBUS_2_INT;
+
+    if (started) {
+        LOG(LOG_ERROR, "Only one Thunder click is supported, click on bus#%d ignored", bus);
+        return false;
+    }
+    thunderBus = bus;
+    sem_init(&interruptRaised, 0, 0);
+    if (spi_init() < 0 || !writeRegister(AS3935_CMD_PRESET_DEFAULT, AS3935_DIRECT_COMMAND) ||
+        !writeRegister(AS3935_REG_AFE, AS3935_AFE_OUTDOOR)) {
+        LOG(LOG_ERROR, "Can't configure Thunder click on bus#%d", bus);
+        return false;
+    }
+
+    // calibrate the RC oscillators, TRCO has to be shown on IRQ for a moment to finish it
+    writeRegister(AS3935_CMD_CALIB_RCO, AS3935_DIRECT_COMMAND);
+    updateRegister(AS3935_REG_TUNING, AS3935_DISPLAY_TRCO, AS3935_DISPLAY_TRCO);
+    schedulerSleepMs(AS3935_INT_SETTLE_MS);
+    updateRegister(AS3935_REG_TUNING, AS3935_DISPLAY_TRCO, 0);
+    stats.noiseFloor = AS3935_NOISE_FLOOR_DEFAULT;
+
+    if (gpio_monitor_init() < 0 ||
+        (callbackId = gpio_monitor_add_callback(pin, GPIO_RISING, &interruptCallback)) < 0) {
+        LOG(LOG_ERROR, "Can't monitor IRQ of Thunder click on bus#%d", bus);
+        return false;
+    }
+    started = true;
+    LOG(LOG_INFO, "Thunder click on bus#%d listening", bus);
+    return true;
+}
+
+bool thunderWaitStrike(int timeoutMs, ThunderStrike *strike) {
+    struct timespec deadline;
+    uint8_t interrupt;
+    bool raised;
+
+    if (!started) {
+        schedulerSleepMs(timeoutMs);
+        return false;
+    }
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += (long)(timeoutMs % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+    while (!(raised = sem_timedwait(&interruptRaised, &deadline) == 0) && errno == EINTR);
+
+    int64_t now = schedulerNowMs();
+    recover(now);
+    if (raised) {
+        schedulerSleepMs(AS3935_INT_SETTLE_MS);
+    }
+    // edges coming while the register is read would be for the same interrupt
+    while (sem_trywait(&interruptRaised) == 0);
+    if (!readRegister(AS3935_REG_INTERRUPT, &interrupt)) {
+        return false;
+    }
+
+    switch (interrupt & AS3935_INT_MASK) {
+        case 0:
+            return false;
+        case AS3935_INT_NOISE:
+            stats.interrupts++;
+            handleNoise(now);
+            return false;
+        case AS3935_INT_DISTURBER:
+            stats.interrupts++;
+            handleDisturber(now);
+            return false;
+        case AS3935_INT_LIGHTNING:
+            stats.interrupts++;
+            if (!readStrike(strike)) {
+                return false;
+            }
+            stats.strikes++;
+            strikeTimes[strikeCount++ % THUNDER_STRIKE_HISTORY] = now;
+            strike->interruptUs = raised ? interruptUs : statsStart();
+            LOG(LOG_INFO, "Lightning strike: distance = %d km, energy = %u", strike->distance, strike->energy);
+            return true;
+        default:
+            LOG(LOG_WARN, "Unexpected Thunder interrupt 0x%02x", interrupt);
+            return false;
+    }
+}
+
+const ThunderStats *thunderGetStats(void) {
+    return &stats;
+}
+
+int thunderStrikesWithin(int64_t windowMs) {
+    int64_t now = schedulerNowMs();
+    unsigned int index;
+    int count = 0;
+
+    for (index = 0; index < strikeCount && index < THUNDER_STRIKE_HISTORY; index++) {
+        if (now - strikeTimes[index] < windowMs) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void thunderStop(void) {
+    if (!started) {
+        return;
+    }
+    gpio_monitor_remove_callback(callbackId);
+    gpio_monitor_release();
+    spi_release();
+    started = false;
+}
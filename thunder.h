@@ -0,0 +1,79 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file thunder.h
+ * @brief AS3935 lightning sensor of the Thunder click, driven by its IRQ line.
+ */
+
+#ifndef THUNDER_H
+#define THUNDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! \{
+/** Distance reported when the storm is out of range (> 40 km). */
+#define THUNDER_DISTANCE_OUT_OF_RANGE   (0x3F)
+/** Disturbers within THUNDER_BURST_WINDOW_MS which get disturbers masked for THUNDER_MASK_HOLDOFF_MS. */
+#define THUNDER_DISTURBER_BURST         (5)
+/** Noise interrupts within THUNDER_BURST_WINDOW_MS which raise the noise floor threshold by one step. */
+#define THUNDER_NOISE_BURST             (2)
+#define THUNDER_BURST_WINDOW_MS         (10000)
+#define THUNDER_MASK_HOLDOFF_MS         (60000)
+/** Quiet time after which raised noise floor threshold goes one step down again. */
+#define THUNDER_NOISE_RECOVERY_MS       (600000)
+/** Strikes remembered for the strike rate. */
+#define THUNDER_STRIKE_HISTORY          (256)
+//! \}
+
+typedef struct {
+    int distance;           /**< km, THUNDER_DISTANCE_OUT_OF_RANGE when unknown */
+    uint32_t energy;        /**< raw energy of the strike, no physical unit */
+    int64_t interruptUs;    /**< statsStart() time the IRQ fired at */
+} ThunderStrike;
+
+typedef struct {
+    unsigned long interrupts;
+    unsigned long strikes;
+    unsigned long disturbers;
+    unsigned long noise;
+    unsigned long masked;       /**< times disturbers got masked after a burst */
+    int noiseFloor;             /**< current noise floor threshold step, 0-7 */
+} ThunderStats;
+
+/** Configure AS3935 on the bus and start listening to its IRQ line. Only one Thunder click is supported. */
+bool thunderStart(uint8_t bus);
+
+/**
+ * Wait until the IRQ line reports an event and handle it. Returns true for a lightning strike, disturbers and noise
+ * are only accounted. Without an edge within timeoutMs the interrupt register is polled, so an edge lost while the
+ * line stayed high never stalls the sensor.
+ */
+bool thunderWaitStrike(int timeoutMs, ThunderStrike *strike);
+
+const ThunderStats *thunderGetStats(void);
+
+/** Number of strikes within the last windowMs, up to the last THUNDER_STRIKE_HISTORY ones. */
+int thunderStrikesWithin(int64_t windowMs);
+
+void thunderStop(void);
+
+#endif  /* THUNDER_H */
@@ -0,0 +1,134 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "trace.h"
+#include "log.h"
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    int64_t startMs;        /**< wall clock, epoch ms */
+} TraceHeader;
+
+static FILE *recordFile = NULL;
+static int64_t startMonotonicMs;
+static FILE *replayFile = NULL;
+
+static int64_t monotonicMs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+bool traceOpen(const char *path) {
+    struct timespec now;
+
+    recordFile = fopen(path, "w");
+    if (recordFile == NULL) {
+        LOG(LOG_ERROR, "Can't open trace %s", path);
+        return false;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    startMonotonicMs = monotonicMs();
+    TraceHeader header = {TRACE_MAGIC, TRACE_VERSION, sizeof(TraceRecord),
+                          (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000};
+    fwrite(&header, sizeof(header), 1, recordFile);
+    LOG(LOG_INFO, "Recording trace into %s", path);
+    return true;
+}
+
+bool traceRecording(void) {
+    return recordFile != NULL;
+}
+
+/** Records are small enough for one stdio write each, which is atomic with respect to other threads. */
+static void append(TraceRecordType type, int objectId, int instance, double value) {
+    TraceRecord record;
+
+    if (recordFile == NULL) {
+        return;
+    }
+    memset(&record, 0, sizeof(record));
+    record.timeMs = (uint32_t)(monotonicMs() - startMonotonicMs);
+    record.objectId = (uint16_t)objectId;
+    record.instance = (uint16_t)instance;
+    record.type = (uint8_t)type;
+    record.value = (float)value;
+    fwrite(&record, sizeof(record), 1, recordFile);
+}
+
+void traceRead(int objectId, int instance, double value) {
+    append(TraceRecord_Read, objectId, instance, value);
+}
+
+void traceCycle(void) {
+    append(TraceRecord_Cycle, 0, 0, 0);
+}
+
+void traceStage(StatsStage stage, uint64_t us, StatsOutcome outcome) {
+    append(TraceRecord_Stage, stage, outcome, us / 1000.0);
+}
+
+void traceClose(void) {
+    if (recordFile != NULL) {
+        fclose(recordFile);
+        recordFile = NULL;
+    }
+}
+
+bool traceReplayOpen(const char *path, int64_t *startMs) {
+    TraceHeader header;
+
+    replayFile = fopen(path, "r");
+    if (replayFile == NULL) {
+        LOG(LOG_ERROR, "Can't open trace %s", path);
+        return false;
+    }
+    if (fread(&header, sizeof(header), 1, replayFile) != 1 || header.magic != TRACE_MAGIC ||
+            header.version != TRACE_VERSION || header.recordSize != sizeof(TraceRecord)) {
+        LOG(LOG_ERROR, "%s is not a trace of this version", path);
+        traceReplayClose();
+        return false;
+    }
+    *startMs = header.startMs;
+    return true;
+}
+
+bool traceReplayNext(TraceRecord *record) {
+    return replayFile != NULL && fread(record, sizeof(*record), 1, replayFile) == 1;
+}
+
+void traceReplayRewind(void) {
+    if (replayFile != NULL) {
+        fseek(replayFile, sizeof(TraceHeader), SEEK_SET);
+    }
+}
+
+void traceReplayClose(void) {
+    if (replayFile != NULL) {
+        fclose(replayFile);
+        replayFile = NULL;
+    }
+}
@@ -0,0 +1,81 @@
+/************************************************************************************************************************
+ Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies.
+ All rights reserved.
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ following conditions are met:
+     1. Redistributions of source code must retain the above copyright notice, this list of conditions and the
+        following disclaimer.
+     2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+        following disclaimer in the documentation and/or other materials provided with the distribution.
+     3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+        products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE 
+ USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+************************************************************************************************************************/
+
+/**
+ * @file trace.h
+ * @brief Compact binary trace of sensor reads, publishing cycles and stage timings, recorded in the field and
+ * replayed off the device.
+ *
+ * The file starts with a header holding the wall clock time the trace started, fixed size records follow. Recording
+ * may be called from any thread, records of one thread keep their order.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "stats.h"
+
+//! \{
+#define TRACE_MAGIC     (0x52545357)    // "WSTR"
+#define TRACE_VERSION   (1)
+//! \}
+
+typedef enum {
+    TraceRecord_Read = 0,   /**< value read from a click or a remote node */
+    TraceRecord_Cycle,      /**< publisher took the samples gathered so far */
+    TraceRecord_Stage       /**< stage timing, Awa operations among them */
+} TraceRecordType;
+
+typedef struct {
+    uint32_t timeMs;        /**< since the trace started */
+    uint16_t objectId;      /**< of a read, stage of a stage timing */
+    uint16_t instance;      /**< of a read, outcome of a stage timing */
+    uint8_t type;
+    uint8_t reserved[3];
+    float value;            /**< value read, duration of a stage in ms */
+} TraceRecord;
+
+/** Start recording into the file, replaces the one there. */
+bool traceOpen(const char *path);
+
+bool traceRecording(void);
+
+void traceRead(int objectId, int instance, double value);
+
+void traceCycle(void);
+
+void traceStage(StatsStage stage, uint64_t us, StatsOutcome outcome);
+
+void traceClose(void);
+
+/** Open trace for replay and get the wall clock time it started in epoch ms. */
+bool traceReplayOpen(const char *path, int64_t *startMs);
+
+/** Next record of the replayed trace, false at its end. */
+bool traceReplayNext(TraceRecord *record);
+
+/** Start replaying from the first record again. */
+void traceReplayRewind(void);
+
+void traceReplayClose(void);
+
+#endif  /* TRACE_H */